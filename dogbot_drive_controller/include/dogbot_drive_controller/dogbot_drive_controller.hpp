@@ -21,14 +21,19 @@
 #ifndef DOGBOT_DRIVE_CONTROLLER_DOGBOT_DRIVE_CONTROLLER_HPP_
 #define DOGBOT_DRIVE_CONTROLLER_DOGBOT_DRIVE_CONTROLLER_HPP_
 
+#include <array>
 #include <chrono>
 #include <cmath>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "controller_interface/controller_interface.hpp"
 #include "dogbot_drive_controller/odometry.hpp"
+#include "dogbot_realtime/realtime_logger.hpp"
+#include "dogbot_realtime/realtime_publisher.hpp"
+#include "dogbot_realtime/triple_buffer.hpp"
 #include "dogbot_drive_controller/visibility_control.h"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
@@ -37,9 +42,6 @@
 #include "odometry.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_lifecycle/state.hpp"
-#include "realtime_tools/realtime_box.h"
-#include "realtime_tools/realtime_buffer.h"
-#include "realtime_tools/realtime_publisher.h"
 #include "tf2_msgs/msg/tf_message.hpp"
 
 // auto-generated by generate_parameter_library
@@ -91,14 +93,32 @@ namespace dogbot_drive_controller {
                 const rclcpp_lifecycle::State &previous_state) override;
 
     protected:
+        enum Wheel : size_t
+        {
+            LF,
+            RF,
+            LB,
+            RB,
+            WHEEL_COUNT
+        };
+
+        // Interfaces of a wheel, resolved in on_activate() and null while inactive.
         struct WheelHandle {
-            std::reference_wrapper<const hardware_interface::LoanedStateInterface> feedback;
-            std::reference_wrapper<hardware_interface::LoanedCommandInterface> velocity;
+            const hardware_interface::LoanedStateInterface *feedback = nullptr;
+            hardware_interface::LoanedCommandInterface *velocity = nullptr;
         };
 
-        controller_interface::CallbackReturn configure_wheel(const std::string &wheel_name);
+        controller_interface::CallbackReturn configure_wheel(Wheel wheel, const std::string &wheel_name);
+
+        std::array<WheelHandle, WHEEL_COUNT> wheel_handles_;
 
-        std::map<std::string, WheelHandle> registered_handles_;
+        // Kinematic constants derived from params_ in on_configure()
+        double wheel_separation_k_ = 0.0; // [m] half the sum of the wheel separations
+        double inverse_wheel_radius_ = 0.0; // [1/m]
+
+        // Hardware sample time of the wheel feedback, if params_.timestamp_interface is set
+        const hardware_interface::LoanedStateInterface *timestamp_handle_ = nullptr;
+        double previous_sample_stamp_ = std::numeric_limits<double>::quiet_NaN();
 
         // Parameters from ROS
         std::shared_ptr<ParamListener> param_listener_;
@@ -111,19 +131,22 @@ namespace dogbot_drive_controller {
         // Timeout to consider cmd_vel commands old
         std::chrono::milliseconds cmd_vel_timeout_{500};
 
+        // update() hands odometry and its transform to these, whose threads publish them
         std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> odometry_publisher_ = nullptr;
-        std::shared_ptr<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>
-                realtime_odometry_publisher_ = nullptr;
+        std::unique_ptr<dogbot_realtime::RealtimePublisher<nav_msgs::msg::Odometry>>
+                realtime_odometry_publisher_;
 
         std::shared_ptr<rclcpp::Publisher<tf2_msgs::msg::TFMessage>> odometry_transform_publisher_ =
                 nullptr;
-        std::shared_ptr<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>
-                realtime_odometry_transform_publisher_ = nullptr;
+        std::unique_ptr<dogbot_realtime::RealtimePublisher<tf2_msgs::msg::TFMessage>>
+                realtime_odometry_transform_publisher_;
 
         bool subscriber_is_active_ = false;
         rclcpp::Subscription<Twist>::SharedPtr velocity_command_subscriber_ = nullptr;
+        rclcpp::Subscription<geometry_msgs::msg::Twist>::SharedPtr velocity_command_unstamped_subscriber_ = nullptr;
         
-        realtime_tools::RealtimeBox<std::shared_ptr<Twist>> received_velocity_msg_ptr_{nullptr};
+        // Latest command, from the subscription to update()
+        dogbot_realtime::TripleBuffer<Twist> received_velocity_msg_;
 
         rclcpp::Time previous_update_timestamp_{0};
 
@@ -134,6 +157,9 @@ namespace dogbot_drive_controller {
 
         bool is_halted_ = false;
 
+        // update() logs through this rather than the node's logger, which may block
+        std::unique_ptr<dogbot_realtime::RealtimeLogger> rt_logger_;
+
         void reset();
 
         void halt();
@@ -26,20 +26,26 @@
 #define DOGBOT_DRIVE_CONTROLLER_ODOMETRY_HPP_
 
 #include <cmath>
+#include <memory>
 
 #include "rclcpp/time.hpp"
-// \note The versions conditioning is added here to support the source-compatibility with Humble
-#if RCPPUTILS_VERSION_MAJOR >= 2 && RCPPUTILS_VERSION_MINOR >= 6
-#include "rcpputils/rolling_mean_accumulator.hpp"
-#else
-
-#include "rcppmath/rolling_mean_accumulator.hpp"
-
-#endif
+#include "dogbot_drive_controller/velocity_filter.hpp"
 
 namespace dogbot_drive_controller {
     class Odometry {
     public:
+        // How the pose follows the body displacement measured over one update, which is taken
+        // to be at a constant body velocity. EULER applies it along the initial heading,
+        // RUNGE_KUTTA_2 along the mean heading, RUNGE_KUTTA_4 by Simpson's rule over the turn,
+        // and EXACT follows the arc it traces; they only differ while turning, by more the
+        // further the robot turns within an update.
+        enum class Integration {
+            EULER,
+            RUNGE_KUTTA_2,
+            RUNGE_KUTTA_4,
+            EXACT
+        };
+
         explicit Odometry(size_t velocity_rolling_window_size = 10);
 
         void init(const rclcpp::Time &time);
@@ -64,14 +70,14 @@ namespace dogbot_drive_controller {
 
         void setVelocityRollingWindowSize(size_t velocity_rolling_window_size);
 
-    private:
-// \note The versions conditioning is added here to support the source-compatibility with Humble
-#if RCPPUTILS_VERSION_MAJOR >= 2 && RCPPUTILS_VERSION_MINOR >= 6
-        using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
-#else
-        using RollingMeanAccumulator = rcppmath::RollingMeanAccumulator<double>;
-#endif
+        // Replaces the velocity filters, discarding their samples; not to be called from the
+        // control loop, as it allocates.
+        void setVelocityFilter(const VelocityFilterParams &params);
 
+        void setIntegration(Integration integration) { integration_ = integration; }
+
+    private:
+        // Moves the pose by a displacement [m, m, rad] in the robot frame.
         void integrate(double linear_x, double linear_y, double angular);
 
         void resetAccumulators();
@@ -93,17 +99,19 @@ namespace dogbot_drive_controller {
         double wheel_separation_k_;
         double wheel_radius_;
 
+        Integration integration_ = Integration::EXACT;
+
         // Previous wheel position/state [rad]:
         double lf_wheel_old_pos_;
         double rf_wheel_old_pos_;
         double lb_wheel_old_pos_;
         double rb_wheel_old_pos_;
 
-        // Rolling mean accumulators for the linear and angular velocities:
-        size_t velocity_rolling_window_size_;
-        RollingMeanAccumulator linear_accumulator_x_;
-        RollingMeanAccumulator linear_accumulator_y_;
-        RollingMeanAccumulator angular_accumulator_;
+        // Filters estimating the linear and angular velocities from the displacements:
+        VelocityFilterParams velocity_filter_params_;
+        std::unique_ptr<VelocityFilter> linear_filter_x_;
+        std::unique_ptr<VelocityFilter> linear_filter_y_;
+        std::unique_ptr<VelocityFilter> angular_filter_;
     };
 
 }  // namespace dogbot_drive_controller
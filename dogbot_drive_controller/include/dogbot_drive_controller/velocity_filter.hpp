@@ -0,0 +1,156 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DOGBOT_DRIVE_CONTROLLER_VELOCITY_FILTER_HPP_
+#define DOGBOT_DRIVE_CONTROLLER_VELOCITY_FILTER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// \note The versions conditioning is added here to support the source-compatibility with Humble
+#if RCPPUTILS_VERSION_MAJOR >= 2 && RCPPUTILS_VERSION_MINOR >= 6
+#include "rcpputils/rolling_mean_accumulator.hpp"
+#else
+
+#include "rcppmath/rolling_mean_accumulator.hpp"
+
+#endif
+
+namespace dogbot_drive_controller {
+    // Estimates a velocity from the displacements measured over successive, possibly uneven,
+    // intervals. Filters allocate only when made, so update() is fit for the control loop.
+    class VelocityFilter {
+    public:
+        virtual ~VelocityFilter() = default;
+
+        // Takes the displacement over the last `dt` [s], which is positive, and returns the
+        // velocity estimate.
+        virtual double update(double displacement, double dt) = 0;
+
+        // Forgets all samples.
+        virtual void reset() = 0;
+    };
+
+    struct VelocityFilterParams {
+        // rolling_mean, ema, time_window, savitzky_golay or alpha_beta
+        std::string type = "rolling_mean";
+        // [samples] of rolling_mean, time_window and savitzky_golay
+        size_t window_size = 10;
+        // [s] of ema
+        double time_constant = 0.1;
+        // gains of alpha_beta
+        double alpha = 0.5;
+        double beta = 0.1;
+    };
+
+    // Throws std::invalid_argument for an unknown type.
+    std::unique_ptr<VelocityFilter> makeVelocityFilter(const VelocityFilterParams &params);
+
+    // Mean of the last window_size velocities, each sample counting the same however long its
+    // interval. This is what the odometry always did.
+    class RollingMeanFilter : public VelocityFilter {
+    public:
+        explicit RollingMeanFilter(size_t window_size);
+
+        double update(double displacement, double dt) override;
+
+        void reset() override;
+
+    private:
+// \note The versions conditioning is added here to support the source-compatibility with Humble
+#if RCPPUTILS_VERSION_MAJOR >= 2 && RCPPUTILS_VERSION_MINOR >= 6
+        using RollingMeanAccumulator = rcpputils::RollingMeanAccumulator<double>;
+#else
+        using RollingMeanAccumulator = rcppmath::RollingMeanAccumulator<double>;
+#endif
+
+        size_t window_size_;
+        RollingMeanAccumulator accumulator_;
+    };
+
+    // Exponential moving average with a time constant rather than a per-sample weight, so a
+    // long interval moves the estimate further than a short one.
+    class EmaFilter : public VelocityFilter {
+    public:
+        explicit EmaFilter(double time_constant);
+
+        double update(double displacement, double dt) override;
+
+        void reset() override;
+
+    private:
+        double time_constant_;
+        double velocity_ = 0.0;
+        bool primed_ = false;
+    };
+
+    // Distance over time across the last window_size intervals, i.e. the mean velocity
+    // weighted by the length of each interval.
+    class TimeWindowFilter : public VelocityFilter {
+    public:
+        explicit TimeWindowFilter(size_t window_size);
+
+        double update(double displacement, double dt) override;
+
+        void reset() override;
+
+    private:
+        std::vector<double> displacements_;
+        std::vector<double> intervals_;
+        size_t next_ = 0;
+        size_t count_ = 0;
+    };
+
+    // Slope at the newest sample of the least-squares quadratic through the last window_size
+    // positions, fitted at their actual times. It lags less than averaging the velocities over
+    // the same window, at the price of more noise.
+    class SavitzkyGolayFilter : public VelocityFilter {
+    public:
+        explicit SavitzkyGolayFilter(size_t window_size);
+
+        double update(double displacement, double dt) override;
+
+        void reset() override;
+
+    private:
+        std::vector<double> times_;     // [s] oldest first once full, see next_
+        std::vector<double> positions_;
+        size_t next_ = 0;
+        size_t count_ = 0;
+        double time_ = 0.0;
+        double position_ = 0.0;
+    };
+
+    // Alpha-beta tracker of position and velocity: each interval predicts the position at the
+    // current velocity and corrects both by the prediction error, scaled by alpha and beta.
+    class AlphaBetaFilter : public VelocityFilter {
+    public:
+        AlphaBetaFilter(double alpha, double beta);
+
+        double update(double displacement, double dt) override;
+
+        void reset() override;
+
+    private:
+        double alpha_;
+        double beta_;
+        double error_ = 0.0; // tracked position minus measured position
+        double velocity_ = 0.0;
+        bool primed_ = false;
+    };
+}  // namespace dogbot_drive_controller
+
+#endif  // DOGBOT_DRIVE_CONTROLLER_VELOCITY_FILTER_HPP_
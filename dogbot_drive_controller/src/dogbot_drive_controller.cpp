@@ -20,16 +20,21 @@
 #include <vector>
 
 #include "dogbot_drive_controller/dogbot_drive_controller.hpp"
+#include "dogbot_realtime/rclcpp_sink.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
-#include "lifecycle_msgs/msg/state.hpp"
 #include "rclcpp/logging.hpp"
 #include "tf2/LinearMath/Quaternion.h"
 
 namespace
 {
     constexpr auto DEFAULT_COMMAND_TOPIC = "~/cmd_vel";
+    constexpr auto DEFAULT_UNSTAMPED_COMMAND_TOPIC = "~/cmd_vel_unstamped";
     constexpr auto DEFAULT_ODOMETRY_TOPIC = "~/odom";
     constexpr auto DEFAULT_TRANSFORM_TOPIC = "/tf";
+
+    // Messages logged from update(), see DogBotDriveController::rt_logger_
+    constexpr dogbot_realtime::LogCode INVALID_FEEDBACK = {dogbot_realtime::Severity::ERROR, "The wheel %s is invalid "};
+    constexpr dogbot_realtime::LogCode ODOMETRY_FAILED = {dogbot_realtime::Severity::ERROR, "Failed to update odometry"};
 } // namespace
 
 namespace dogbot_drive_controller
@@ -39,7 +44,6 @@ namespace dogbot_drive_controller
     using controller_interface::InterfaceConfiguration;
     using hardware_interface::HW_IF_POSITION;
     using hardware_interface::HW_IF_VELOCITY;
-    using lifecycle_msgs::msg::State;
 
     DogBotDriveController::DogBotDriveController() : controller_interface::ControllerInterface() {}
 
@@ -61,6 +65,9 @@ namespace dogbot_drive_controller
             return controller_interface::CallbackReturn::ERROR;
         }
         odometry_.init(get_node()->get_clock()->now());
+
+        rt_logger_ =
+            std::make_unique<dogbot_realtime::RealtimeLogger>(dogbot_realtime::rclcpp_sink(get_node()->get_logger()));
         return controller_interface::CallbackReturn::SUCCESS;
     }
 
@@ -81,14 +88,18 @@ namespace dogbot_drive_controller
         conf_names.push_back(params_.rf_wheel_name + "/" + feedback_type());
         conf_names.push_back(params_.lb_wheel_name + "/" + feedback_type());
         conf_names.push_back(params_.rb_wheel_name + "/" + feedback_type());
+        if (!params_.timestamp_interface.empty())
+        {
+            conf_names.push_back(params_.timestamp_interface);
+        }
         return {interface_configuration_type::INDIVIDUAL, conf_names};
     }
 
     controller_interface::return_type DogBotDriveController::update(
         const rclcpp::Time &time, const rclcpp::Duration &)
     {
-        auto logger = get_node()->get_logger();
-        if (get_state().id() == State::PRIMARY_STATE_INACTIVE)
+        // unlike get_state(), which locks the node's state machine, the handles are only set while active
+        if (wheel_handles_[LF].velocity == nullptr)
         {
             if (!is_halted_)
             {
@@ -98,49 +109,59 @@ namespace dogbot_drive_controller
             return controller_interface::return_type::OK;
         }
 
-        std::shared_ptr<Twist> command;
-        received_velocity_msg_ptr_.get(command);
+        const Twist &command = received_velocity_msg_.read();
+        double linear_command_x = command.twist.linear.x;
+        double linear_command_y = command.twist.linear.y;
+        double angular_command = command.twist.angular.z;
 
-        if (command == nullptr)
-        {
-            RCLCPP_WARN(logger, "Velocity message received was a nullptr.");
-            return controller_interface::return_type::ERROR;
-        }
-
-        const auto age_of_last_command = time - command->header.stamp;
-        // brake if cmd_vel has timeout, override the stored command
+        const auto age_of_last_command = time - command.header.stamp;
+        // brake if cmd_vel has timeout
         if (age_of_last_command > cmd_vel_timeout_)
         {
-            command->twist.linear.x = 0.0;
-            command->twist.linear.y = 0.0;
-            command->twist.angular.z = 0.0;
+            linear_command_x = 0.0;
+            linear_command_y = 0.0;
+            angular_command = 0.0;
         }
 
-        double &linear_command_x = command->twist.linear.x;
-        double &linear_command_y = command->twist.linear.y;
-        double &angular_command = command->twist.angular.z;
-
         // RCLCPP_INFO(logger, "Received command: linear_x: %f, linear_y: %f, angular: %f", linear_command_x, linear_command_y, angular_command);
 
         previous_update_timestamp_ = time;
 
-        const double wheel_separation_k = (params_.wheel_separation_x + params_.wheel_separation_y) / 2.0;
-        const double wheel_radius = params_.wheel_radius;
-
-        const double lf_feedback = registered_handles_.at(params_.lf_wheel_name).feedback.get().get_value();
-        const double rf_feedback = registered_handles_.at(params_.rf_wheel_name).feedback.get().get_value();
-        const double lb_feedback = registered_handles_.at(params_.lb_wheel_name).feedback.get().get_value();
-        const double rb_feedback = registered_handles_.at(params_.rb_wheel_name).feedback.get().get_value();
+        const double lf_feedback = wheel_handles_[LF].feedback->get_value();
+        const double rf_feedback = wheel_handles_[RF].feedback->get_value();
+        const double lb_feedback = wheel_handles_[LB].feedback->get_value();
+        const double rb_feedback = wheel_handles_[RB].feedback->get_value();
 
         if (std::isnan(lf_feedback) || std::isnan(rf_feedback) || std::isnan(lb_feedback) || std::isnan(rb_feedback))
         {
-            RCLCPP_ERROR(logger, "The wheel %s is invalid ", feedback_type());
+            rt_logger_->log(INVALID_FEEDBACK, feedback_type());
             return controller_interface::return_type::ERROR;
         }
 
-        if (!odometry_.update(lf_feedback, rf_feedback, lb_feedback, rb_feedback, time))
+        // integrate over the hardware's sampling interval when it reports one, since the
+        // feedback is latched at a point the controller's update time does not reflect
+        rclcpp::Time sample_time = time;
+        bool fresh_feedback = true;
+        if (timestamp_handle_ != nullptr)
         {
-            RCLCPP_ERROR(logger, "Failed to update odometry");
+            const double stamp = timestamp_handle_->get_value();
+            fresh_feedback = !std::isnan(stamp) && stamp != previous_sample_stamp_;
+            if (fresh_feedback)
+            {
+                sample_time = rclcpp::Time(static_cast<int64_t>(stamp * 1e9), RCL_STEADY_TIME);
+                if (std::isnan(previous_sample_stamp_))
+                {
+                    // first sample since activation only starts the interval
+                    odometry_.init(sample_time);
+                    fresh_feedback = false;
+                }
+                previous_sample_stamp_ = stamp;
+            }
+        }
+
+        if (fresh_feedback && !odometry_.update(lf_feedback, rf_feedback, lb_feedback, rb_feedback, sample_time))
+        {
+            rt_logger_->log(ODOMETRY_FAILED);
             return controller_interface::return_type::ERROR;
         }
 
@@ -167,25 +188,22 @@ namespace dogbot_drive_controller
 
         if (should_publish)
         {
-            if (realtime_odometry_publisher_->trylock())
+            auto &odometry_message = realtime_odometry_publisher_->message();
+            odometry_message.header.stamp = time;
+            odometry_message.pose.pose.position.x = odometry_.getX();
+            odometry_message.pose.pose.position.y = odometry_.getY();
+            odometry_message.pose.pose.orientation.x = orientation.x();
+            odometry_message.pose.pose.orientation.y = orientation.y();
+            odometry_message.pose.pose.orientation.z = orientation.z();
+            odometry_message.pose.pose.orientation.w = orientation.w();
+            odometry_message.twist.twist.linear.x = odometry_.getLinearX();
+            odometry_message.twist.twist.linear.y = odometry_.getLinearY();
+            odometry_message.twist.twist.angular.z = odometry_.getAngular();
+            realtime_odometry_publisher_->publish();
+
+            if (params_.enable_odom_tf)
             {
-                auto &odometry_message = realtime_odometry_publisher_->msg_;
-                odometry_message.header.stamp = time;
-                odometry_message.pose.pose.position.x = odometry_.getX();
-                odometry_message.pose.pose.position.y = odometry_.getY();
-                odometry_message.pose.pose.orientation.x = orientation.x();
-                odometry_message.pose.pose.orientation.y = orientation.y();
-                odometry_message.pose.pose.orientation.z = orientation.z();
-                odometry_message.pose.pose.orientation.w = orientation.w();
-                odometry_message.twist.twist.linear.x = odometry_.getLinearX();
-                odometry_message.twist.twist.linear.y = odometry_.getLinearY();
-                odometry_message.twist.twist.angular.z = odometry_.getAngular();
-                realtime_odometry_publisher_->unlockAndPublish();
-            }
-
-            if (params_.enable_odom_tf && realtime_odometry_transform_publisher_->trylock())
-            {
-                auto &transform = realtime_odometry_transform_publisher_->msg_.transforms.front();
+                auto &transform = realtime_odometry_transform_publisher_->message().transforms.front();
                 transform.header.stamp = time;
                 transform.transform.translation.x = odometry_.getX();
                 transform.transform.translation.y = odometry_.getY();
@@ -193,26 +211,26 @@ namespace dogbot_drive_controller
                 transform.transform.rotation.y = orientation.y();
                 transform.transform.rotation.z = orientation.z();
                 transform.transform.rotation.w = orientation.w();
-                realtime_odometry_transform_publisher_->unlockAndPublish();
+                realtime_odometry_transform_publisher_->publish();
             }
         }
 
         // compute wheels angular velocities (to rad/s):
         // TODO: check if the y-calculations are correct
         const double angular_velocity_lf =
-            (linear_command_x + linear_command_y - angular_command * wheel_separation_k) / wheel_radius;
+            (linear_command_x + linear_command_y - angular_command * wheel_separation_k_) * inverse_wheel_radius_;
         const double angular_velocity_rf =
-            (linear_command_x - linear_command_y + angular_command * wheel_separation_k) / wheel_radius;
+            (linear_command_x - linear_command_y + angular_command * wheel_separation_k_) * inverse_wheel_radius_;
         const double angular_velocity_lb =
-            (linear_command_x - linear_command_y - angular_command * wheel_separation_k) / wheel_radius;
+            (linear_command_x - linear_command_y - angular_command * wheel_separation_k_) * inverse_wheel_radius_;
         const double angular_velocity_rb =
-            (linear_command_x + linear_command_y + angular_command * wheel_separation_k) / wheel_radius;
+            (linear_command_x + linear_command_y + angular_command * wheel_separation_k_) * inverse_wheel_radius_;
 
         // Set wheels angular velocities:
-        registered_handles_.at(params_.lf_wheel_name).velocity.get().set_value(angular_velocity_lf);
-        registered_handles_.at(params_.rf_wheel_name).velocity.get().set_value(angular_velocity_rf);
-        registered_handles_.at(params_.lb_wheel_name).velocity.get().set_value(angular_velocity_lb);
-        registered_handles_.at(params_.rb_wheel_name).velocity.get().set_value(angular_velocity_rb);
+        wheel_handles_[LF].velocity->set_value(angular_velocity_lf);
+        wheel_handles_[RF].velocity->set_value(angular_velocity_rf);
+        wheel_handles_[LB].velocity->set_value(angular_velocity_lb);
+        wheel_handles_[RB].velocity->set_value(angular_velocity_rb);
 
         return controller_interface::return_type::OK;
     }
@@ -234,41 +252,92 @@ namespace dogbot_drive_controller
         const double wheel_radius = params_.wheel_radius;
 
         odometry_.setWheelParams(wheel_separation_x, wheel_separation_y, wheel_radius);
-        odometry_.setVelocityRollingWindowSize(params_.velocity_rolling_window_size);
+        wheel_separation_k_ = (wheel_separation_x + wheel_separation_y) / 2.0;
+        inverse_wheel_radius_ = 1.0 / wheel_radius;
+        VelocityFilterParams velocity_filter;
+        velocity_filter.type = params_.velocity_filter;
+        velocity_filter.window_size = static_cast<size_t>(params_.velocity_rolling_window_size);
+        velocity_filter.time_constant = params_.velocity_filter_time_constant;
+        velocity_filter.alpha = params_.velocity_filter_alpha;
+        velocity_filter.beta = params_.velocity_filter_beta;
+        odometry_.setVelocityFilter(velocity_filter);
+        if (params_.odometry_integration == "euler")
+        {
+            odometry_.setIntegration(Odometry::Integration::EULER);
+        }
+        else if (params_.odometry_integration == "runge_kutta_2")
+        {
+            odometry_.setIntegration(Odometry::Integration::RUNGE_KUTTA_2);
+        }
+        else if (params_.odometry_integration == "runge_kutta_4")
+        {
+            odometry_.setIntegration(Odometry::Integration::RUNGE_KUTTA_4);
+        }
+        else
+        {
+            odometry_.setIntegration(Odometry::Integration::EXACT);
+        }
 
         cmd_vel_timeout_ = std::chrono::milliseconds{static_cast<int>(params_.cmd_vel_timeout * 1000.0)};
 
         reset();
 
-        const Twist empty_twist;
-        received_velocity_msg_ptr_.set(std::make_shared<Twist>(empty_twist));
-
         // initialize command subscriber
-        velocity_command_subscriber_ = get_node()->create_subscription<Twist>(
-            DEFAULT_COMMAND_TOPIC, rclcpp::SystemDefaultsQoS(),
-            [this](const std::shared_ptr<Twist> msg) -> void
-            {
-                if (!subscriber_is_active_)
+        rclcpp::QoS command_qos = rclcpp::SystemDefaultsQoS();
+        rclcpp::SubscriptionOptions command_options;
+        if (params_.cmd_vel_intra_process)
+        {
+            command_qos = rclcpp::QoS(rclcpp::KeepLast(1));
+            command_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+        }
+        if (params_.use_stamped_vel)
+        {
+            velocity_command_subscriber_ = get_node()->create_subscription<Twist>(
+                DEFAULT_COMMAND_TOPIC, command_qos,
+                [this](const std::shared_ptr<const Twist> msg) -> void
                 {
-                    RCLCPP_WARN(get_node()->get_logger(), "Can't accept new commands. subscriber is inactive");
-                    return;
-                }
-                if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
+                    if (!subscriber_is_active_)
+                    {
+                        RCLCPP_WARN(get_node()->get_logger(), "Can't accept new commands. subscriber is inactive");
+                        return;
+                    }
+                    Twist &command = received_velocity_msg_.write_slot();
+                    command = *msg;
+                    if ((msg->header.stamp.sec == 0) && (msg->header.stamp.nanosec == 0))
+                    {
+                        RCLCPP_WARN_ONCE(
+                            get_node()->get_logger(),
+                            "Received TwistStamped with zero timestamp, setting it to current "
+                            "time, this message will only be shown once");
+                        command.header.stamp = get_node()->get_clock()->now();
+                    }
+                    received_velocity_msg_.publish();
+                },
+                command_options);
+        }
+        else
+        {
+            // stamped here on receipt, sparing the producer a node that only adds the stamp
+            velocity_command_unstamped_subscriber_ = get_node()->create_subscription<geometry_msgs::msg::Twist>(
+                DEFAULT_UNSTAMPED_COMMAND_TOPIC, command_qos,
+                [this](const std::shared_ptr<const geometry_msgs::msg::Twist> msg) -> void
                 {
-                    RCLCPP_WARN_ONCE(
-                        get_node()->get_logger(),
-                        "Received TwistStamped with zero timestamp, setting it to current "
-                        "time, this message will only be shown once");
-                    msg->header.stamp = get_node()->get_clock()->now();
-                }
-                received_velocity_msg_ptr_.set(std::move(msg));
-            });
+                    if (!subscriber_is_active_)
+                    {
+                        RCLCPP_WARN(get_node()->get_logger(), "Can't accept new commands. subscriber is inactive");
+                        return;
+                    }
+                    Twist &command = received_velocity_msg_.write_slot();
+                    command.header.stamp = get_node()->get_clock()->now();
+                    command.twist = *msg;
+                    received_velocity_msg_.publish();
+                },
+                command_options);
+        }
 
         // initialize odometry publisher and message
         odometry_publisher_ = get_node()->create_publisher<nav_msgs::msg::Odometry>(DEFAULT_ODOMETRY_TOPIC,
                                                                                     rclcpp::SystemDefaultsQoS());
-        realtime_odometry_publisher_ = std::make_shared<realtime_tools::RealtimePublisher<nav_msgs::msg::Odometry>>(
-            odometry_publisher_);
 
         // append the tf prefix if there is one
         std::string tf_prefix;
@@ -295,7 +364,7 @@ namespace dogbot_drive_controller
         const auto odom_frame_id = tf_prefix + params_.odom_frame_id;
         const auto base_frame_id = tf_prefix + params_.base_frame_id;
 
-        auto &odometry_message = realtime_odometry_publisher_->msg_;
+        nav_msgs::msg::Odometry odometry_message;
         odometry_message.header.frame_id = odom_frame_id;
         odometry_message.child_frame_id = base_frame_id;
 
@@ -319,15 +388,22 @@ namespace dogbot_drive_controller
         // initialize transform publisher and message
         odometry_transform_publisher_ = get_node()->create_publisher<tf2_msgs::msg::TFMessage>(DEFAULT_TRANSFORM_TOPIC,
                                                                                                rclcpp::SystemDefaultsQoS());
-        realtime_odometry_transform_publisher_ = std::make_shared<realtime_tools::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
-            odometry_transform_publisher_);
 
         // keeping track of odom and base_link transforms only
-        auto &odometry_transform_message = realtime_odometry_transform_publisher_->msg_;
+        tf2_msgs::msg::TFMessage odometry_transform_message;
         odometry_transform_message.transforms.resize(1);
         odometry_transform_message.transforms.front().header.frame_id = odom_frame_id;
         odometry_transform_message.transforms.front().child_frame_id = base_frame_id;
 
+        // every message update() fills starts as these, so it only sets the values that change;
+        // checking twice per publish period keeps the added delay within half of it
+        const auto poll_period = std::chrono::nanoseconds(publish_period_.nanoseconds() / 2);
+        realtime_odometry_publisher_ = std::make_unique<dogbot_realtime::RealtimePublisher<nav_msgs::msg::Odometry>>(
+            odometry_publisher_, odometry_message, poll_period);
+        realtime_odometry_transform_publisher_ =
+            std::make_unique<dogbot_realtime::RealtimePublisher<tf2_msgs::msg::TFMessage>>(
+                odometry_transform_publisher_, odometry_transform_message, poll_period);
+
         previous_update_timestamp_ = get_node()->get_clock()->now();
         return controller_interface::CallbackReturn::SUCCESS;
     }
@@ -335,10 +411,10 @@ namespace dogbot_drive_controller
     controller_interface::CallbackReturn DogBotDriveController::on_activate(const rclcpp_lifecycle::State &)
     {
         RCLCPP_INFO(get_node()->get_logger(), "Activating!");
-        const auto lf_result = configure_wheel(params_.lf_wheel_name);
-        const auto rf_result = configure_wheel(params_.rf_wheel_name);
-        const auto lb_result = configure_wheel(params_.lb_wheel_name);
-        const auto rb_result = configure_wheel(params_.rb_wheel_name);
+        const auto lf_result = configure_wheel(LF, params_.lf_wheel_name);
+        const auto rf_result = configure_wheel(RF, params_.rf_wheel_name);
+        const auto lb_result = configure_wheel(LB, params_.lb_wheel_name);
+        const auto rb_result = configure_wheel(RB, params_.rb_wheel_name);
 
         if (
             lf_result == controller_interface::CallbackReturn::ERROR ||
@@ -349,6 +425,25 @@ namespace dogbot_drive_controller
             return controller_interface::CallbackReturn::ERROR;
         }
 
+        timestamp_handle_ = nullptr;
+        previous_sample_stamp_ = std::numeric_limits<double>::quiet_NaN();
+        if (!params_.timestamp_interface.empty())
+        {
+            const auto timestamp_handle = std::find_if(
+                state_interfaces_.cbegin(), state_interfaces_.cend(),
+                [this](const auto &interface)
+                {
+                    return interface.get_name() == params_.timestamp_interface;
+                });
+            if (timestamp_handle == state_interfaces_.cend())
+            {
+                RCLCPP_ERROR(get_node()->get_logger(), "Unable to obtain timestamp state handle %s",
+                             params_.timestamp_interface.c_str());
+                return controller_interface::CallbackReturn::ERROR;
+            }
+            timestamp_handle_ = &*timestamp_handle;
+        }
+
         is_halted_ = false;
         subscriber_is_active_ = true;
 
@@ -363,14 +458,14 @@ namespace dogbot_drive_controller
             halt();
             is_halted_ = true;
         }
-        registered_handles_.clear();
+        wheel_handles_ = {};
+        timestamp_handle_ = nullptr;
         return controller_interface::CallbackReturn::SUCCESS;
     }
 
     controller_interface::CallbackReturn DogBotDriveController::on_cleanup(const rclcpp_lifecycle::State &)
     {
         reset();
-        received_velocity_msg_ptr_.set(std::make_shared<Twist>());
         return controller_interface::CallbackReturn::SUCCESS;
     }
 
@@ -384,12 +479,14 @@ namespace dogbot_drive_controller
     {
         odometry_.resetOdometry();
 
-        registered_handles_.clear();
+        wheel_handles_ = {};
 
         subscriber_is_active_ = false;
         velocity_command_subscriber_.reset();
+        velocity_command_unstamped_subscriber_.reset();
 
-        received_velocity_msg_ptr_.set(nullptr);
+        // a zero stamp keeps the robot braked until the first command
+        received_velocity_msg_.reset(Twist());
         is_halted_ = false;
     }
 
@@ -400,13 +497,16 @@ namespace dogbot_drive_controller
 
     void DogBotDriveController::halt()
     {
-        for (const auto &[name, wheel_handle] : registered_handles_)
+        for (const auto &wheel_handle : wheel_handles_)
         {
-            wheel_handle.velocity.get().set_value(0.0);
+            if (wheel_handle.velocity != nullptr)
+            {
+                wheel_handle.velocity->set_value(0.0);
+            }
         }
     }
 
-    controller_interface::CallbackReturn DogBotDriveController::configure_wheel(const std::string &wheel_name)
+    controller_interface::CallbackReturn DogBotDriveController::configure_wheel(Wheel wheel, const std::string &wheel_name)
     {
         auto logger = get_node()->get_logger();
 
@@ -445,7 +545,7 @@ namespace dogbot_drive_controller
             return controller_interface::CallbackReturn::ERROR;
         }
 
-        registered_handles_.insert({wheel_name, WheelHandle{std::ref(*state_handle), std::ref(*command_handle)}});
+        wheel_handles_[wheel] = WheelHandle{&*state_handle, &*command_handle};
 
         return controller_interface::CallbackReturn::SUCCESS;
     }
@@ -34,11 +34,8 @@ namespace dogbot_drive_controller {
               lf_wheel_old_pos_(0.0),
               rf_wheel_old_pos_(0.0),
               lb_wheel_old_pos_(0.0),
-              rb_wheel_old_pos_(0.0),
-              velocity_rolling_window_size_(velocity_rolling_window_size),
-              linear_accumulator_x_(velocity_rolling_window_size),
-              linear_accumulator_y_(velocity_rolling_window_size),
-              angular_accumulator_(velocity_rolling_window_size) {
+              rb_wheel_old_pos_(0.0) {
+        setVelocityRollingWindowSize(velocity_rolling_window_size);
     }
 
     void Odometry::init(const rclcpp::Time &time) {
@@ -80,13 +77,10 @@ namespace dogbot_drive_controller {
 
         timestamp_ = time;
 
-        // get the rolling mean of the velocity
-        linear_accumulator_x_.accumulate(linear_x / dt);
-        linear_accumulator_y_.accumulate(linear_y / dt);
-        angular_accumulator_.accumulate(angular / dt);
-        linear_x_ = linear_accumulator_x_.getRollingMean();
-        linear_y_ = linear_accumulator_y_.getRollingMean();
-        angular_ = angular_accumulator_.getRollingMean();
+        // estimate the velocity from the displacements over this and earlier intervals
+        linear_x_ = linear_filter_x_->update(linear_x, dt);
+        linear_y_ = linear_filter_y_->update(linear_y, dt);
+        angular_ = angular_filter_->update(angular, dt);
 
         return true;
     }
@@ -103,20 +97,53 @@ namespace dogbot_drive_controller {
     }
 
     void Odometry::setVelocityRollingWindowSize(size_t velocity_rolling_window_size) {
-        velocity_rolling_window_size_ = velocity_rolling_window_size;
-        resetAccumulators();
+        VelocityFilterParams params = velocity_filter_params_;
+        params.window_size = velocity_rolling_window_size;
+        setVelocityFilter(params);
+    }
+
+    void Odometry::setVelocityFilter(const VelocityFilterParams &params) {
+        velocity_filter_params_ = params;
+        linear_filter_x_ = makeVelocityFilter(params);
+        linear_filter_y_ = makeVelocityFilter(params);
+        angular_filter_ = makeVelocityFilter(params);
     }
 
     void Odometry::integrate(double linear_x, double linear_y, double angular) {
-        x_ += linear_x;
-        y_ += linear_y;
+        // world frame displacement = integral over the update of R(heading) * (linear_x, linear_y),
+        // the heading turning steadily by `angular`; c and s approximate the integrals of its
+        // cosine and sine over the update
+        double c = 0.0;
+        double s = 0.0;
+        const Integration integration =
+                integration_ == Integration::EXACT && std::fabs(angular) < 1e-6 ? Integration::RUNGE_KUTTA_2 : integration_;
+        switch (integration) {
+            case Integration::EULER:
+                c = std::cos(heading_);
+                s = std::sin(heading_);
+                break;
+            case Integration::RUNGE_KUTTA_2:
+                c = std::cos(heading_ + angular / 2.0);
+                s = std::sin(heading_ + angular / 2.0);
+                break;
+            case Integration::RUNGE_KUTTA_4:
+                c = (std::cos(heading_) + 4.0 * std::cos(heading_ + angular / 2.0) + std::cos(heading_ + angular)) / 6.0;
+                s = (std::sin(heading_) + 4.0 * std::sin(heading_ + angular / 2.0) + std::sin(heading_ + angular)) / 6.0;
+                break;
+            case Integration::EXACT:
+                c = (std::sin(heading_ + angular) - std::sin(heading_)) / angular;
+                s = (std::cos(heading_) - std::cos(heading_ + angular)) / angular;
+                break;
+        }
+        x_ += linear_x * c - linear_y * s;
+        y_ += linear_x * s + linear_y * c;
         heading_ += angular;
     }
 
     void Odometry::resetAccumulators() {
-        linear_accumulator_x_ = RollingMeanAccumulator(velocity_rolling_window_size_);
-        linear_accumulator_y_ = RollingMeanAccumulator(velocity_rolling_window_size_);
-        angular_accumulator_ = RollingMeanAccumulator(velocity_rolling_window_size_);
+        linear_filter_x_->reset();
+        linear_filter_y_->reset();
+        angular_filter_->reset();
     }
 
 } // namespace dogbot_drive_controller
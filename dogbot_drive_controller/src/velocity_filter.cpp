@@ -0,0 +1,176 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dogbot_drive_controller/velocity_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace dogbot_drive_controller {
+    std::unique_ptr<VelocityFilter> makeVelocityFilter(const VelocityFilterParams &params) {
+        const size_t window_size = std::max<size_t>(params.window_size, 1);
+        if (params.type == "rolling_mean") {
+            return std::make_unique<RollingMeanFilter>(window_size);
+        }
+        if (params.type == "ema") {
+            return std::make_unique<EmaFilter>(params.time_constant);
+        }
+        if (params.type == "time_window") {
+            return std::make_unique<TimeWindowFilter>(window_size);
+        }
+        if (params.type == "savitzky_golay") {
+            return std::make_unique<SavitzkyGolayFilter>(window_size);
+        }
+        if (params.type == "alpha_beta") {
+            return std::make_unique<AlphaBetaFilter>(params.alpha, params.beta);
+        }
+        throw std::invalid_argument("unknown velocity filter " + params.type);
+    }
+
+    RollingMeanFilter::RollingMeanFilter(size_t window_size)
+            : window_size_(window_size), accumulator_(window_size) {
+    }
+
+    double RollingMeanFilter::update(double displacement, double dt) {
+        accumulator_.accumulate(displacement / dt);
+        return accumulator_.getRollingMean();
+    }
+
+    void RollingMeanFilter::reset() {
+        accumulator_ = RollingMeanAccumulator(window_size_);
+    }
+
+    EmaFilter::EmaFilter(double time_constant) : time_constant_(time_constant) {
+    }
+
+    double EmaFilter::update(double displacement, double dt) {
+        const double velocity = displacement / dt;
+        if (!primed_ || time_constant_ <= 0.0) {
+            velocity_ = velocity;
+            primed_ = true;
+            return velocity_;
+        }
+        velocity_ += (1.0 - std::exp(-dt / time_constant_)) * (velocity - velocity_);
+        return velocity_;
+    }
+
+    void EmaFilter::reset() {
+        velocity_ = 0.0;
+        primed_ = false;
+    }
+
+    TimeWindowFilter::TimeWindowFilter(size_t window_size)
+            : displacements_(window_size, 0.0), intervals_(window_size, 0.0) {
+    }
+
+    double TimeWindowFilter::update(double displacement, double dt) {
+        displacements_[next_] = displacement;
+        intervals_[next_] = dt;
+        next_ = (next_ + 1) % displacements_.size();
+        count_ = std::min(count_ + 1, displacements_.size());
+
+        // summed afresh rather than kept as running sums, which would drift
+        double distance = 0.0;
+        double time = 0.0;
+        for (size_t i = 0; i < count_; ++i) {
+            distance += displacements_[i];
+            time += intervals_[i];
+        }
+        return distance / time;
+    }
+
+    void TimeWindowFilter::reset() {
+        next_ = 0;
+        count_ = 0;
+    }
+
+    SavitzkyGolayFilter::SavitzkyGolayFilter(size_t window_size)
+            : times_(window_size + 1, 0.0), positions_(window_size + 1, 0.0) {
+    }
+
+    double SavitzkyGolayFilter::update(double displacement, double dt) {
+        // a window of n intervals spans n + 1 positions, the first being where the robot started
+        if (count_ == 0) {
+            times_[0] = 0.0;
+            positions_[0] = 0.0;
+            next_ = 1;
+            count_ = 1;
+        }
+        time_ += dt;
+        position_ += displacement;
+        times_[next_] = time_;
+        positions_[next_] = position_;
+        next_ = (next_ + 1) % times_.size();
+        count_ = std::min(count_ + 1, times_.size());
+        if (count_ < 3) {
+            return displacement / dt;
+        }
+
+        // weighted sums of the samples relative to the newest one, which keeps them well scaled
+        double s[5] = {};
+        double t[3] = {};
+        for (size_t i = 0; i < count_; ++i) {
+            const double tau = times_[i] - time_;
+            const double q = positions_[i] - position_;
+            double power = 1.0;
+            for (size_t k = 0; k < 5; ++k) {
+                s[k] += power;
+                if (k < 3) {
+                    t[k] += q * power;
+                }
+                power *= tau;
+            }
+        }
+        // solve the normal equations of q = a + b tau + c tau^2 for the slope b by Cramer's rule
+        const double det = s[0] * (s[2] * s[4] - s[3] * s[3]) - s[1] * (s[1] * s[4] - s[3] * s[2]) +
+                           s[2] * (s[1] * s[3] - s[2] * s[2]);
+        const double det_b = s[0] * (t[1] * s[4] - s[3] * t[2]) - t[0] * (s[1] * s[4] - s[3] * s[2]) +
+                             s[2] * (s[1] * t[2] - t[1] * s[2]);
+        if (std::fabs(det) < 1e-18) {
+            return displacement / dt;
+        }
+        return det_b / det;
+    }
+
+    void SavitzkyGolayFilter::reset() {
+        next_ = 0;
+        count_ = 0;
+        time_ = 0.0;
+        position_ = 0.0;
+    }
+
+    AlphaBetaFilter::AlphaBetaFilter(double alpha, double beta) : alpha_(alpha), beta_(beta) {
+    }
+
+    double AlphaBetaFilter::update(double displacement, double dt) {
+        if (!primed_) {
+            error_ = 0.0;
+            velocity_ = displacement / dt;
+            primed_ = true;
+            return velocity_;
+        }
+        // predict at the current velocity, then correct by how far the measurement disagrees
+        const double predicted_error = error_ + velocity_ * dt - displacement;
+        error_ = (1.0 - alpha_) * predicted_error;
+        velocity_ -= beta_ * predicted_error / dt;
+        return velocity_;
+    }
+
+    void AlphaBetaFilter::reset() {
+        error_ = 0.0;
+        velocity_ = 0.0;
+        primed_ = false;
+    }
+}  // namespace dogbot_drive_controller
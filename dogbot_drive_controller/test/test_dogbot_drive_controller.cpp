@@ -0,0 +1,254 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <dlfcn.h>
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dogbot_drive_controller/dogbot_drive_controller.hpp"
+#include "hardware_interface/loaned_command_interface.hpp"
+#include "hardware_interface/loaned_state_interface.hpp"
+#include "hardware_interface/types/hardware_interface_type_values.hpp"
+#include "lifecycle_msgs/msg/state.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace
+{
+    // Allocations and lock acquisitions of the test thread while counting; the threads of the
+    // controller's logger and publishers, and of rclcpp, are not counted.
+    thread_local bool counting = false;
+    thread_local size_t allocations = 0;
+    thread_local size_t locks = 0;
+
+    // The next definition of `name`, looked up on first use. The lookup may race, but every
+    // thread finds the same function.
+    template <typename Function>
+    Function next(std::atomic<void *> &slot, const char *name)
+    {
+        void *function = slot.load(std::memory_order_relaxed);
+        if (function == nullptr)
+        {
+            function = dlsym(RTLD_NEXT, name);
+            slot.store(function, std::memory_order_relaxed);
+        }
+        return reinterpret_cast<Function>(function);
+    }
+
+    std::atomic<void *> next_mutex_lock{nullptr};
+    std::atomic<void *> next_mutex_trylock{nullptr};
+    std::atomic<void *> next_rwlock_rdlock{nullptr};
+    std::atomic<void *> next_rwlock_wrlock{nullptr};
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (counting)
+    {
+        ++allocations;
+    }
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Interposed on libc, including for the controller's library since the test exports them;
+// std::mutex and std::shared_mutex lock through these.
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    if (counting)
+    {
+        ++locks;
+    }
+    return next<int (*)(pthread_mutex_t *)>(next_mutex_lock, "pthread_mutex_lock")(mutex);
+}
+
+extern "C" int pthread_mutex_trylock(pthread_mutex_t *mutex)
+{
+    if (counting)
+    {
+        ++locks;
+    }
+    return next<int (*)(pthread_mutex_t *)>(next_mutex_trylock, "pthread_mutex_trylock")(mutex);
+}
+
+extern "C" int pthread_rwlock_rdlock(pthread_rwlock_t *lock)
+{
+    if (counting)
+    {
+        ++locks;
+    }
+    return next<int (*)(pthread_rwlock_t *)>(next_rwlock_rdlock, "pthread_rwlock_rdlock")(lock);
+}
+
+extern "C" int pthread_rwlock_wrlock(pthread_rwlock_t *lock)
+{
+    if (counting)
+    {
+        ++locks;
+    }
+    return next<int (*)(pthread_rwlock_t *)>(next_rwlock_wrlock, "pthread_rwlock_wrlock")(lock);
+}
+
+namespace
+{
+    using hardware_interface::HW_IF_POSITION;
+    using hardware_interface::HW_IF_VELOCITY;
+    using lifecycle_msgs::msg::State;
+
+    class TestableDogBotDriveController : public dogbot_drive_controller::DogBotDriveController
+    {
+    public:
+        using DogBotDriveController::received_velocity_msg_;
+    };
+
+    class DogBotDriveControllerTest : public ::testing::Test
+    {
+    protected:
+        static void SetUpTestSuite()
+        {
+            rclcpp::init(0, nullptr);
+        }
+
+        static void TearDownTestSuite()
+        {
+            rclcpp::shutdown();
+        }
+
+        void SetUp() override
+        {
+            ASSERT_EQ(controller_.init("dogbot_drive_controller"), controller_interface::return_type::OK);
+            const auto node = controller_.get_node();
+            node->set_parameter(rclcpp::Parameter("wheel_separation_x", 0.2));
+            node->set_parameter(rclcpp::Parameter("wheel_separation_y", 0.2));
+            node->set_parameter(rclcpp::Parameter("wheel_radius", 0.03));
+            node->set_parameter(rclcpp::Parameter("publish_rate", 100.0));
+        }
+
+        // Configures and activates the controller on the wheels' interfaces.
+        void activate()
+        {
+            ASSERT_EQ(controller_.configure().id(), State::PRIMARY_STATE_INACTIVE);
+
+            // the loaned interfaces point into these, so they must not reallocate
+            hardware_states_.reserve(WHEELS.size());
+            hardware_commands_.reserve(WHEELS.size());
+            for (size_t wheel = 0; wheel < WHEELS.size(); ++wheel)
+            {
+                hardware_states_.emplace_back(WHEELS[wheel], HW_IF_POSITION, &positions_[wheel]);
+                hardware_commands_.emplace_back(WHEELS[wheel], HW_IF_VELOCITY, &velocities_[wheel]);
+            }
+            std::vector<hardware_interface::LoanedStateInterface> state_interfaces;
+            std::vector<hardware_interface::LoanedCommandInterface> command_interfaces;
+            for (size_t wheel = 0; wheel < WHEELS.size(); ++wheel)
+            {
+                state_interfaces.emplace_back(hardware_states_[wheel]);
+                command_interfaces.emplace_back(hardware_commands_[wheel]);
+            }
+            controller_.assign_interfaces(std::move(command_interfaces), std::move(state_interfaces));
+
+            ASSERT_EQ(controller_.get_node()->activate().id(), State::PRIMARY_STATE_ACTIVE);
+        }
+
+        // Runs update() for `period`, moving the wheels at their commanded velocities.
+        void step(rclcpp::Time &time, const rclcpp::Duration &period)
+        {
+            for (size_t wheel = 0; wheel < WHEELS.size(); ++wheel)
+            {
+                positions_[wheel] += velocities_[wheel] * period.seconds();
+            }
+            time += period;
+            ASSERT_EQ(controller_.update(time, period), controller_interface::return_type::OK);
+        }
+
+        const std::array<std::string, 4> WHEELS = {"lf_wheel_joint", "rf_wheel_joint", "lb_wheel_joint",
+                                                   "rb_wheel_joint"};
+
+        std::array<double, 4> positions_ = {};
+        std::array<double, 4> velocities_ = {};
+        std::vector<hardware_interface::StateInterface> hardware_states_;
+        std::vector<hardware_interface::CommandInterface> hardware_commands_;
+        TestableDogBotDriveController controller_; // last, as it holds loans of the interfaces
+    };
+
+    TEST_F(DogBotDriveControllerTest, update_neither_allocates_nor_locks)
+    {
+        activate();
+
+        auto listener = std::make_shared<rclcpp::Node>("odometry_listener");
+        size_t odometry_messages = 0;
+        const auto subscription = listener->create_subscription<nav_msgs::msg::Odometry>(
+            "/dogbot_drive_controller/odom", rclcpp::SystemDefaultsQoS(),
+            [&odometry_messages](const nav_msgs::msg::Odometry::SharedPtr) { ++odometry_messages; });
+
+        rclcpp::Time time(1, 0, RCL_ROS_TIME);
+        const auto period = rclcpp::Duration::from_seconds(0.002);
+
+        auto &command = controller_.received_velocity_msg_.write_slot();
+        command.header.stamp = time;
+        command.twist.linear.x = 0.3;
+        command.twist.angular.z = 0.5;
+        controller_.received_velocity_msg_.publish();
+
+        // the first cycle starts the publish rate limiter, which it does by catching the
+        // exception comparing times from different clocks
+        step(time, period);
+
+        counting = true;
+        for (int i = 0; i < 100; ++i)
+        {
+            step(time, period);
+        }
+        counting = false;
+
+        EXPECT_EQ(allocations, 0u);
+        EXPECT_EQ(locks, 0u);
+        for (const double velocity : velocities_)
+        {
+            EXPECT_NE(velocity, 0.0);
+        }
+
+        // the publisher threads deliver what update() hands them, once the listener is discovered
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (odometry_messages == 0 && std::chrono::steady_clock::now() < deadline)
+        {
+            step(time, period);
+            rclcpp::spin_some(listener);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_GT(odometry_messages, 0u);
+    }
+} // namespace
@@ -43,8 +43,36 @@ def generate_launch_description():
         )
     )
 
+    declared_arguments.append(
+        DeclareLaunchArgument(
+            "imu_hardware",
+            default_value="false",
+            description="Read the ICM-20948 through ros2_control and start imu_sensor_broadcaster.",
+        )
+    )
+
+    declared_arguments.append(
+        DeclareLaunchArgument(
+            "mock_hardware",
+            default_value="false",
+            description="Drive a simulated plant in place of the Arduino boards.",
+        )
+    )
+
+    declared_arguments.append(
+        DeclareLaunchArgument(
+            "binary_firmware",
+            default_value="false",
+            description="The boards run firmware with the binary serial protocol; "
+            "the released firmware only speaks ASCII.",
+        )
+    )
+
     # Initialize Arguments
     gui = LaunchConfiguration("gui")
+    imu_hardware = LaunchConfiguration("imu_hardware")
+    mock_hardware = LaunchConfiguration("mock_hardware")
+    binary_firmware = LaunchConfiguration("binary_firmware")
 
     # Get URDF via xacro
     robot_description_content = Command(
@@ -55,6 +83,14 @@ def generate_launch_description():
                 [FindPackageShare("dogbot_hardware"), "urdf", "dogbot.urdf.xacro"]
             ),
             " ",
+            "imu_hardware:=",
+            imu_hardware,
+            " ",
+            "mock_hardware:=",
+            mock_hardware,
+            " ",
+            "binary_firmware:=",
+            binary_firmware,
         ]
     )
     robot_description = {"robot_description": robot_description_content}
@@ -135,6 +171,16 @@ def generate_launch_description():
         ],
     )
     
+    dogbot_imu_broadcaster_spawner = Node(
+        package="controller_manager",
+        executable="spawner",
+        arguments=[
+            "imu_sensor_broadcaster",
+            "--controller-manager",
+            "/controller_manager",
+        ],
+        condition=IfCondition(imu_hardware),
+    )
 
     # Delay rviz start after `joint_state_broadcaster`
     delay_rviz_after_joint_state_broadcaster_spawner = RegisterEventHandler(
@@ -181,7 +227,8 @@ def generate_launch_description():
         delay_rviz_after_joint_state_broadcaster_spawner,
         delay_robot_drive_controller_spawner_after_joint_state_broadcaster_spawner,
         delay_dogbot_servo_controller_spawner_after_joint_state_broadcaster_spawner,
-        delay_dogbot_sonar_broadcaster_spawner_after_joint_state_broadcaster_spawner
+        delay_dogbot_sonar_broadcaster_spawner_after_joint_state_broadcaster_spawner,
+        dogbot_imu_broadcaster_spawner,
     ]
 
     return LaunchDescription(declared_arguments + nodes)
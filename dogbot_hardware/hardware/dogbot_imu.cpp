@@ -0,0 +1,260 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dogbot_hardware/dogbot_imu.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "dogbot_realtime/rclcpp_sink.hpp"
+#include "rclcpp/rclcpp.hpp"
+
+namespace dogbot_hardware
+{
+    namespace
+    {
+        // Messages logged from the control loop, see DogBotImuHardware::logger_.
+        constexpr dogbot_realtime::LogCode FIFO_READ_FAILED = {dogbot_realtime::Severity::ERROR,
+                                                               "Failed to read the ICM-20948 FIFO: %s"};
+    } // namespace
+
+    hardware_interface::CallbackReturn DogBotImuHardware::on_init(
+        const hardware_interface::HardwareInfo &info)
+    {
+        if (
+            hardware_interface::SensorInterface::on_init(info) !=
+            hardware_interface::CallbackReturn::SUCCESS)
+        {
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Initializing... please wait...");
+        logger_ = std::make_unique<dogbot_realtime::RealtimeLogger>(
+            dogbot_realtime::rclcpp_sink(rclcpp::get_logger("DogBotImuHardware")));
+
+        cfg_.i2c_bus = info_.hardware_parameters["i2c_bus"];
+        if (cfg_.i2c_bus.empty())
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"), "No I2C bus configured");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        const auto address = info_.hardware_parameters.find("i2c_address");
+        if (address != info_.hardware_parameters.end())
+        {
+            cfg_.imu.address = static_cast<uint8_t>(std::stoi(address->second, nullptr, 0));
+        }
+        const auto sample_rate = info_.hardware_parameters.find("sample_rate");
+        if (sample_rate != info_.hardware_parameters.end())
+        {
+            cfg_.imu.sample_rate = std::stod(sample_rate->second);
+        }
+        if (cfg_.imu.sample_rate <= 0.0 || cfg_.imu.sample_rate > icm20948::INTERNAL_RATE)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"), "sample_rate must be within (0, 1125] Hz");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        const auto accel_range = info_.hardware_parameters.find("accel_range");
+        if (accel_range != info_.hardware_parameters.end())
+        {
+            cfg_.imu.accel_range = std::stoi(accel_range->second);
+        }
+        const auto gyro_range = info_.hardware_parameters.find("gyro_range");
+        if (gyro_range != info_.hardware_parameters.end())
+        {
+            cfg_.imu.gyro_range = std::stoi(gyro_range->second);
+        }
+        if (!Icm20948::valid_accel_range(cfg_.imu.accel_range) || !Icm20948::valid_gyro_range(cfg_.imu.gyro_range))
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"),
+                         "accel_range must be 2, 4, 8 or 16 and gyro_range 250, 500, 1000 or 2000");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        const auto max_burst = info_.hardware_parameters.find("max_burst");
+        if (max_burst != info_.hardware_parameters.end())
+        {
+            cfg_.imu.max_burst = static_cast<size_t>(std::stoul(max_burst->second));
+        }
+        if (cfg_.imu.max_burst < icm20948::PACKET_SIZE)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"), "max_burst must hold at least one %zu byte FIFO packet",
+                         icm20948::PACKET_SIZE);
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        if (info_.sensors.size() != 1)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"), "Expected exactly one sensor, got %zu",
+                         info_.sensors.size());
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        for (const auto &interface : info_.sensors[0].state_interfaces)
+        {
+            if (find_state(interface.name) == nullptr)
+            {
+                RCLCPP_FATAL(rclcpp::get_logger("DogBotImuHardware"), "Sensor '%s' has unknown state interface '%s'",
+                             info_.sensors[0].name.c_str(), interface.name.c_str());
+                return hardware_interface::CallbackReturn::ERROR;
+            }
+        }
+
+        return hardware_interface::CallbackReturn::SUCCESS;
+    }
+
+    std::vector<hardware_interface::StateInterface> DogBotImuHardware::export_state_interfaces()
+    {
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Exporting State Interfaces... please wait...");
+
+        std::vector<hardware_interface::StateInterface> state_interfaces;
+        const auto &sensor = info_.sensors[0];
+        for (const auto &interface : sensor.state_interfaces)
+        {
+            state_interfaces.emplace_back(sensor.name, interface.name, find_state(interface.name));
+        }
+        return state_interfaces;
+    }
+
+    hardware_interface::CallbackReturn DogBotImuHardware::on_configure(
+        const rclcpp_lifecycle::State & /*previous_state*/)
+    {
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Configuring... please wait...");
+        imu_.reset();
+        bus_.reset();
+        try
+        {
+            bus_ = std::make_unique<LinuxI2cBus>(cfg_.i2c_bus);
+            imu_ = std::make_unique<Icm20948>(*bus_, cfg_.imu);
+            imu_->configure();
+        }
+        catch (const std::exception &e)
+        {
+            RCLCPP_ERROR(rclcpp::get_logger("DogBotImuHardware"), "Failed to configure the ICM-20948 on %s: %s",
+                         cfg_.i2c_bus.c_str(), e.what());
+            imu_.reset();
+            bus_.reset();
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Sampling at %.1f Hz", imu_->sample_rate());
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Successfully configured!");
+        return hardware_interface::CallbackReturn::SUCCESS;
+    }
+
+    hardware_interface::CallbackReturn DogBotImuHardware::on_cleanup(
+        const rclcpp_lifecycle::State & /*previous_state*/)
+    {
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Cleaning... please wait...");
+        imu_.reset();
+        bus_.reset();
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Successfully cleaned up!");
+        return hardware_interface::CallbackReturn::SUCCESS;
+    }
+
+    hardware_interface::CallbackReturn DogBotImuHardware::on_activate(
+        const rclcpp_lifecycle::State & /*previous_state*/)
+    {
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Activating ...please wait...");
+        if (!imu_)
+        {
+            RCLCPP_ERROR(rclcpp::get_logger("DogBotImuHardware"), "Failed to activate!");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        try
+        {
+            // samples queued while inactive are stale
+            imu_->reset_fifo();
+        }
+        catch (const std::exception &e)
+        {
+            RCLCPP_ERROR(rclcpp::get_logger("DogBotImuHardware"), "Failed to activate: %s", e.what());
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        RCLCPP_INFO(rclcpp::get_logger("DogBotImuHardware"), "Successfully activated!");
+        return hardware_interface::CallbackReturn::SUCCESS;
+    }
+
+    hardware_interface::return_type DogBotImuHardware::read(
+        const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
+    {
+        double accel_sum[3] = {0.0, 0.0, 0.0};
+        double gyro_sum[3] = {0.0, 0.0, 0.0};
+        size_t samples = 0;
+        try
+        {
+            samples = imu_->read_fifo([&](const ImuSample &sample)
+                                      {
+                                          for (int i = 0; i < 3; ++i)
+                                          {
+                                              accel_sum[i] += sample.accel[i];
+                                              gyro_sum[i] += sample.gyro[i];
+                                          }
+                                          if (sample.mag_valid)
+                                          {
+                                              std::copy(sample.mag, sample.mag + 3, mag_);
+                                          } });
+        }
+        catch (const std::exception &e)
+        {
+            logger_->log(FIFO_READ_FAILED, e.what());
+            return hardware_interface::return_type::ERROR;
+        }
+
+        // nothing new if the control loop outpaced the chip; keep the previous readings
+        if (samples > 0)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                accel_[i] = accel_sum[i] / static_cast<double>(samples);
+                gyro_[i] = gyro_sum[i] / static_cast<double>(samples);
+            }
+        }
+        fifo_overflows_ = static_cast<double>(imu_->overflows());
+        return hardware_interface::return_type::OK;
+    }
+
+    double *DogBotImuHardware::find_state(const std::string &name)
+    {
+        static const char *const AXES[] = {"x", "y", "z", "w"};
+        for (int i = 0; i < 4; ++i)
+        {
+            const std::string axis = AXES[i];
+            if (i < 3 && name == "linear_acceleration." + axis)
+            {
+                return &accel_[i];
+            }
+            if (i < 3 && name == "angular_velocity." + axis)
+            {
+                return &gyro_[i];
+            }
+            if (i < 3 && name == "magnetic_field." + axis)
+            {
+                return &mag_[i];
+            }
+            if (name == "orientation." + axis)
+            {
+                return &orientation_[i];
+            }
+        }
+        if (name == "fifo_overflows")
+        {
+            return &fifo_overflows_;
+        }
+        return nullptr;
+    }
+
+} // namespace dogbot_hardware
+
+#include "pluginlib/class_list_macros.hpp"
+
+PLUGINLIB_EXPORT_CLASS(
+    dogbot_hardware::DogBotImuHardware, hardware_interface::SensorInterface)
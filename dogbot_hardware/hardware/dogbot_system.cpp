@@ -14,13 +14,110 @@
 
 #include "dogbot_hardware/dogbot_system.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "dogbot_realtime/rclcpp_sink.hpp"
 #include "hardware_interface/types/hardware_interface_type_values.hpp"
 #include "rclcpp/rclcpp.hpp"
 
 namespace dogbot_hardware
 {
+    namespace
+    {
+        // Commands whose round-trip times are exported, with their interface name prefix.
+        constexpr std::pair<LinkStats::Command, const char *> EXPORTED_RTTS[] = {
+            {LinkStats::ENCODERS, "encoders"},
+            {LinkStats::SONAR, "sonar"},
+            {LinkStats::MOTOR, "motor"},
+            {LinkStats::SERVO, "servo"},
+            {LinkStats::CYCLE, "cycle"},
+        };
+
+        std::vector<std::string> split_list(const std::string &list)
+        {
+            std::vector<std::string> items;
+            size_t start = 0;
+            while (start <= list.size())
+            {
+                size_t end = list.find(',', start);
+                if (end == std::string::npos)
+                {
+                    end = list.size();
+                }
+                const size_t first = list.find_first_not_of(" \t", start);
+                const size_t last = list.find_last_not_of(" \t", end - 1);
+                if (first < end && last != std::string::npos && last >= first)
+                {
+                    items.push_back(list.substr(first, last - first + 1));
+                }
+                start = end + 1;
+            }
+            return items;
+        }
+
+        // A board's own capture file: `path` itself if it is the only one, else `path`.<index>.
+        std::string capture_path(const std::string &path, size_t device, size_t device_count)
+        {
+            return device_count == 1 ? path : path + "." + std::to_string(device);
+        }
+
+        const hardware_interface::InterfaceInfo *find_interface(
+            const std::vector<hardware_interface::InterfaceInfo> &interfaces, const std::string &name)
+        {
+            for (const auto &interface : interfaces)
+            {
+                if (interface.name == name)
+                {
+                    return &interface;
+                }
+            }
+            return nullptr;
+        }
+
+        // Messages logged from the control loop, see DogBotSystemHardware::logger_.
+        constexpr dogbot_realtime::LogCode READ_FAILED = {dogbot_realtime::Severity::INFO, "Failed to read!"};
+        constexpr dogbot_realtime::LogCode LINK_RECOVERED = {dogbot_realtime::Severity::INFO,
+                                                             "Serial I/O on %s recovered"};
+        constexpr dogbot_realtime::LogCode LINK_FAILED = {dogbot_realtime::Severity::ERROR, "%s on %s: %s"};
+        constexpr dogbot_realtime::LogCode LINK_DOWN = {dogbot_realtime::Severity::ERROR,
+                                                        "Serial link to %s down after %d failed cycles, reconnecting"};
+        constexpr dogbot_realtime::LogCode JITTER_PERIOD = {
+            dogbot_realtime::Severity::INFO,
+            "%s period over %zu cycles [ms]: p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f"};
+        constexpr dogbot_realtime::LogCode JITTER_LATENCY = {
+            dogbot_realtime::Severity::INFO,
+            "%s latency over %zu cycles [ms]: p50 %.3f, p90 %.3f, p99 %.3f, p99.9 %.3f, max %.3f"};
+        constexpr dogbot_realtime::LogCode IO_PROFILE_FAILED = {dogbot_realtime::Severity::WARN,
+                                                                "Unable to apply the I/O thread profile: %s"};
+
+        // Logs the period and latency percentiles of the window of `recorder`, which must be
+        // complete, and starts the next one.
+        void report_jitter(dogbot_realtime::RealtimeLogger &logger, const char *loop,
+                           dogbot_realtime::JitterRecorder &recorder)
+        {
+            const auto log = [&](const dogbot_realtime::LogCode &code, const dogbot_realtime::DurationHistogram &histogram)
+            {
+                logger.log(code, loop, recorder.cycles(), histogram.percentile(0.5) * 1e-6,
+                           histogram.percentile(0.9) * 1e-6, histogram.percentile(0.99) * 1e-6,
+                           histogram.percentile(0.999) * 1e-6, histogram.max_ns() * 1e-6);
+            };
+            log(JITTER_PERIOD, recorder.period());
+            log(JITTER_LATENCY, recorder.latency());
+            recorder.restart();
+        }
+    } // namespace
+
+    DogBotSystemHardware::~DogBotSystemHardware()
+    {
+        stop_io_thread();
+        stop_reconnect_threads();
+    }
+
     hardware_interface::CallbackReturn DogBotSystemHardware::on_init(
         const hardware_interface::HardwareInfo &info)
     {
@@ -32,37 +129,437 @@ namespace dogbot_hardware
         }
 
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Initializing... please wait...");
+        logger_ = std::make_unique<dogbot_realtime::RealtimeLogger>(
+            dogbot_realtime::rclcpp_sink(rclcpp::get_logger("DogBotSystemHardware")));
 
-        cfg_.device = info_.hardware_parameters["device"];
+        // several boards may share the work; `devices` lists them, `device` names a single one
+        const auto devices = info_.hardware_parameters.find("devices");
+        cfg_.devices = split_list(devices != info_.hardware_parameters.end() ? devices->second
+                                                                             : info_.hardware_parameters["device"]);
+        if (cfg_.devices.empty())
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "No serial device configured");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
         cfg_.baud_rate = std::stoi(info_.hardware_parameters["baud_rate"]);
         cfg_.timeout_ms = std::stoi(info_.hardware_parameters["timeout_ms"]);
         cfg_.enc_counts_per_rev = std::stoi(info_.hardware_parameters["enc_counts_per_rev"]);
 
-        wheel_lf_.setup(info_.hardware_parameters["lf_wheel_name"], cfg_.enc_counts_per_rev);
-        wheel_rf_.setup(info_.hardware_parameters["rf_wheel_name"], cfg_.enc_counts_per_rev);
-        wheel_lb_.setup(info_.hardware_parameters["lb_wheel_name"], cfg_.enc_counts_per_rev);
-        wheel_rb_.setup(info_.hardware_parameters["rb_wheel_name"], cfg_.enc_counts_per_rev);
+        const auto protocol = info_.hardware_parameters.find("protocol");
+        if (protocol == info_.hardware_parameters.end() || protocol->second == "ascii")
+        {
+            cfg_.protocol = Protocol::ASCII;
+        }
+        else if (protocol->second == "binary")
+        {
+            cfg_.protocol = Protocol::BINARY;
+        }
+        else
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "Unknown protocol '%s', expected 'ascii' or 'binary'", protocol->second.c_str());
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        cfg_.batched = info_.hardware_parameters["batched"] == "true";
+        cfg_.pipelined = info_.hardware_parameters["pipelined"] == "true";
+        if (cfg_.pipelined && cfg_.protocol != Protocol::BINARY)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "pipelined requires the binary protocol");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        const auto stream_rate = info_.hardware_parameters.find("stream_rate");
+        if (stream_rate != info_.hardware_parameters.end())
+        {
+            cfg_.stream_rate = std::stoi(stream_rate->second);
+        }
+        if (cfg_.stream_rate < 0 || cfg_.stream_rate > 1000)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "stream_rate must be within [0, 1000] Hz");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        if (cfg_.stream_rate > 0 && cfg_.protocol != Protocol::BINARY)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "stream_rate requires the binary protocol");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        cfg_.async_io = info_.hardware_parameters["async_io"] == "true";
+
+        const auto io_rate = info_.hardware_parameters.find("io_rate");
+        if (io_rate != info_.hardware_parameters.end())
+        {
+            cfg_.io_rate = std::stod(io_rate->second);
+        }
+        if (cfg_.io_rate <= 0.0)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "io_rate must be positive");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        // scheduling of the I/O worker, e.g. a core kept free of the perception stack
+        for (const auto &cpu : split_list(info_.hardware_parameters["io_cpus"]))
+        {
+            cfg_.io_profile.cpus.push_back(std::stoi(cpu));
+        }
+        const auto io_priority = info_.hardware_parameters.find("io_priority");
+        if (io_priority != info_.hardware_parameters.end())
+        {
+            cfg_.io_profile.priority = std::stoi(io_priority->second);
+        }
+        if (cfg_.io_profile.priority < 0 || cfg_.io_profile.priority > 99)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "io_priority must be within [0, 99]");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        if ((!cfg_.io_profile.cpus.empty() || cfg_.io_profile.priority > 0) && !cfg_.async_io)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "io_cpus and io_priority require async_io; the control loop thread belongs to the "
+                         "controller manager");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        cfg_.lock_memory = info_.hardware_parameters["lock_memory"] == "true";
+
+        const auto jitter_cycles = info_.hardware_parameters.find("jitter_cycles");
+        if (jitter_cycles != info_.hardware_parameters.end())
+        {
+            cfg_.jitter_cycles = std::stoi(jitter_cycles->second);
+        }
+        if (cfg_.jitter_cycles < 0)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "jitter_cycles must not be negative");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        const auto sonar_interval = info_.hardware_parameters.find("sonar_interval");
+        if (sonar_interval != info_.hardware_parameters.end())
+        {
+            cfg_.sonar_interval = std::stoi(sonar_interval->second);
+        }
+        if (cfg_.sonar_interval < 1)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "sonar_interval must be at least 1");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        cfg_.delta_commands = info_.hardware_parameters["delta_commands"] == "true";
+        const auto delta_threshold = info_.hardware_parameters.find("delta_threshold");
+        if (delta_threshold != info_.hardware_parameters.end())
+        {
+            cfg_.delta_threshold = std::stod(delta_threshold->second);
+        }
+        const auto keyframe_interval = info_.hardware_parameters.find("keyframe_interval");
+        if (keyframe_interval != info_.hardware_parameters.end())
+        {
+            cfg_.keyframe_interval = std::stoi(keyframe_interval->second);
+        }
+        if (cfg_.delta_threshold < 0.0 || cfg_.keyframe_interval < 0)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "delta_threshold and keyframe_interval must not be negative");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        cfg_.servo_trajectory = info_.hardware_parameters["servo_trajectory"] == "true";
+        const auto servo_max_velocity = info_.hardware_parameters.find("servo_max_velocity");
+        if (servo_max_velocity != info_.hardware_parameters.end())
+        {
+            cfg_.servo_max_velocity = std::stod(servo_max_velocity->second);
+        }
+        const auto servo_trajectory_points = info_.hardware_parameters.find("servo_trajectory_points");
+        if (servo_trajectory_points != info_.hardware_parameters.end())
+        {
+            cfg_.servo_trajectory_points = std::stoi(servo_trajectory_points->second);
+        }
+        if (cfg_.servo_trajectory && cfg_.protocol != Protocol::BINARY)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "servo_trajectory requires the binary protocol");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        if (cfg_.servo_max_velocity <= 0.0 || cfg_.servo_trajectory_points < 1 ||
+            cfg_.servo_trajectory_points > static_cast<int>(protocol::MAX_TRAJECTORY_POINTS))
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "servo_max_velocity must be positive and servo_trajectory_points within [1, %zu]",
+                         protocol::MAX_TRAJECTORY_POINTS);
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        const auto velocity_filter_cutoff = info_.hardware_parameters.find("velocity_filter_cutoff");
+        if (velocity_filter_cutoff != info_.hardware_parameters.end())
+        {
+            cfg_.velocity_filter_cutoff = std::stod(velocity_filter_cutoff->second);
+        }
+        if (cfg_.velocity_filter_cutoff < 0.0)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "velocity_filter_cutoff must not be negative");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+        const auto link_failure_limit = info_.hardware_parameters.find("link_failure_limit");
+        if (link_failure_limit != info_.hardware_parameters.end())
+        {
+            cfg_.link_failure_limit = std::stoi(link_failure_limit->second);
+        }
+        const auto reconnect_min_delay = info_.hardware_parameters.find("reconnect_min_delay");
+        if (reconnect_min_delay != info_.hardware_parameters.end())
+        {
+            cfg_.reconnect_min_delay = std::stod(reconnect_min_delay->second);
+        }
+        const auto reconnect_max_delay = info_.hardware_parameters.find("reconnect_max_delay");
+        if (reconnect_max_delay != info_.hardware_parameters.end())
+        {
+            cfg_.reconnect_max_delay = std::stod(reconnect_max_delay->second);
+        }
+        if (cfg_.link_failure_limit < 1 || cfg_.reconnect_min_delay <= 0.0 ||
+            cfg_.reconnect_max_delay < cfg_.reconnect_min_delay)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "link_failure_limit must be at least 1 and 0 < reconnect_min_delay <= reconnect_max_delay");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
+
+        const auto link_name = info_.hardware_parameters.find("link_name");
+        if (link_name != info_.hardware_parameters.end())
+        {
+            cfg_.link_name = link_name->second;
+        }
+
+        cfg_.mock = info_.hardware_parameters["mock"] == "true";
+        const auto mock_motor_time_constant = info_.hardware_parameters.find("mock_motor_time_constant");
+        if (mock_motor_time_constant != info_.hardware_parameters.end())
+        {
+            cfg_.mock_motor_time_constant = std::stod(mock_motor_time_constant->second);
+        }
+        const auto mock_wall_distance = info_.hardware_parameters.find("mock_wall_distance");
+        if (mock_wall_distance != info_.hardware_parameters.end())
+        {
+            cfg_.mock_wall_distance = std::stod(mock_wall_distance->second);
+        }
+        const auto mock_wheel_radius = info_.hardware_parameters.find("mock_wheel_radius");
+        if (mock_wheel_radius != info_.hardware_parameters.end())
+        {
+            cfg_.mock_wheel_radius = std::stod(mock_wheel_radius->second);
+        }
+        if (cfg_.mock_motor_time_constant < 0.0 || cfg_.mock_wheel_radius <= 0.0)
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "mock_motor_time_constant must not be negative and mock_wheel_radius must be positive");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
 
-        servo_forearm_.setup(info_.hardware_parameters["servo_forearm_name"], 90.0);
-        servo_gripper_.setup(info_.hardware_parameters["servo_gripper_name"], 30.0);
+        cfg_.capture_file = info_.hardware_parameters["capture_file"];
+        cfg_.replay_file = info_.hardware_parameters["replay_file"];
+        const auto replay_speed = info_.hardware_parameters.find("replay_speed");
+        if (replay_speed != info_.hardware_parameters.end())
+        {
+            cfg_.replay_speed = std::stod(replay_speed->second);
+        }
+        if (cfg_.replay_speed < 0.0 || (cfg_.mock && !cfg_.replay_file.empty()))
+        {
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                         "replay_speed must not be negative, and a replay cannot be mocked");
+            return hardware_interface::CallbackReturn::ERROR;
+        }
 
-        sonar_.setup(info_.hardware_parameters["sonar_name"]);
+        if (!register_components())
+        {
+            return hardware_interface::CallbackReturn::ERROR;
+        }
 
         return hardware_interface::CallbackReturn::SUCCESS;
     }
 
+    bool DogBotSystemHardware::register_components()
+    {
+        const size_t device_count = cfg_.devices.size();
+        wheels_ = WheelTable();
+        wheels_.setup(cfg_.enc_counts_per_rev);
+        servos_ = ServoTable();
+        sonars_ = SonarTable();
+        std::vector<size_t> motors_used(device_count, 0), servos_used(device_count, 0), sonars_used(device_count, 0);
+
+        // every joint or sensor takes the next free channel of its kind on its board
+        std::vector<const hardware_interface::ComponentInfo *> components;
+        for (const auto &joint : info_.joints)
+        {
+            components.push_back(&joint);
+        }
+        for (const auto &sensor : info_.sensors)
+        {
+            components.push_back(&sensor);
+        }
+        for (const auto *component : components)
+        {
+            size_t device = 0;
+            const auto device_param = component->parameters.find("device");
+            if (device_param != component->parameters.end())
+            {
+                const long index = std::stol(device_param->second);
+                if (index < 0 || static_cast<size_t>(index) >= device_count)
+                {
+                    RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                                 "%s: device must index into the %zu configured devices", component->name.c_str(),
+                                 device_count);
+                    return false;
+                }
+                device = static_cast<size_t>(index);
+            }
+
+            const char *kind = nullptr;
+            if (find_interface(component->command_interfaces, hardware_interface::HW_IF_VELOCITY) != nullptr)
+            {
+                if (motors_used[device] < protocol::MOTOR_CHANNELS)
+                {
+                    wheels_.add(component->name, device, motors_used[device]++);
+                    continue;
+                }
+                kind = "motor";
+            }
+            else if (const auto *position =
+                         find_interface(component->command_interfaces, hardware_interface::HW_IF_POSITION))
+            {
+                if (servos_used[device] < protocol::SERVO_CHANNELS)
+                {
+                    const double initial = position->initial_value.empty() ? 0.0 : std::stod(position->initial_value);
+                    servos_.add(component->name, device, servos_used[device]++, initial);
+                    continue;
+                }
+                kind = "servo";
+            }
+            else if (find_interface(component->state_interfaces, "range") != nullptr)
+            {
+                if (sonars_used[device] < 1)
+                {
+                    sonars_.add(component->name, device);
+                    ++sonars_used[device];
+                    continue;
+                }
+                kind = "sonar";
+            }
+            else
+            {
+                RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"),
+                             "%s has neither a velocity or position command nor a range state interface",
+                             component->name.c_str());
+                return false;
+            }
+            RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "%s: device %zu has no %s channel left",
+                         component->name.c_str(), device, kind);
+            return false;
+        }
+
+        // the exported timestamp is one board's sample time, so the odometry only gets encoder
+        // counts and a time that belong together if all wheels are sampled by that board
+        for (size_t i = 1; i < wheels_.size(); ++i)
+        {
+            if (wheels_.device[i] != wheels_.device[0])
+            {
+                RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "All wheels must be on the same device");
+                return false;
+            }
+        }
+        stamp_device_ = wheels_.size() > 0 ? wheels_.device[0] : sonars_.size() > 0 ? sonars_.device[0] : 0;
+
+        devices_.clear();
+        for (size_t i = 0; i < device_count; ++i)
+        {
+            auto device = std::make_unique<Device>();
+            uint8_t channels = 0;
+            for (size_t w = 0; w < wheels_.size(); ++w)
+            {
+                if (wheels_.device[w] == i)
+                {
+                    channels |= static_cast<uint8_t>(1u << wheels_.channel[w]);
+                    device->reads_encoders = true;
+                }
+            }
+            for (size_t s = 0; s < servos_.size(); ++s)
+            {
+                if (servos_.device[s] == i)
+                {
+                    channels |= static_cast<uint8_t>(1u << (protocol::MOTOR_CHANNELS + servos_.channel[s]));
+                }
+            }
+            device->reads_sonar = sonars_used[i] > 0;
+            try
+            {
+                std::unique_ptr<Port> port;
+                if (cfg_.mock)
+                {
+                    // each board simulates the motors wired to it; its sonar sees them drive
+                    auto loopback = std::make_unique<LoopbackPort>();
+                    loopback->arduino().motor_time_constant = cfg_.mock_motor_time_constant;
+                    loopback->arduino().sonar_range = cfg_.mock_wall_distance;
+                    loopback->arduino().metres_per_count =
+                        2.0 * M_PI * cfg_.mock_wheel_radius / cfg_.enc_counts_per_rev;
+                    port = std::move(loopback);
+                }
+                else if (!cfg_.replay_file.empty())
+                {
+                    port = std::make_unique<ReplayPort>(capture_path(cfg_.replay_file, i, device_count),
+                                                        cfg_.replay_speed);
+                }
+                else
+                {
+                    port = std::make_unique<SerialPort>();
+                }
+                if (!cfg_.capture_file.empty())
+                {
+                    port = std::make_unique<CapturePort>(std::move(port),
+                                                         capture_path(cfg_.capture_file, i, device_count));
+                }
+                device->serial.set_port(std::move(port));
+            }
+            catch (const std::exception &e)
+            {
+                RCLCPP_FATAL(rclcpp::get_logger("DogBotSystemHardware"), "%s", e.what());
+                return false;
+            }
+            device->serial.set_logger(logger_.get());
+            device->serial.set_channels(channels);
+            // the threshold is given in wheel rad/s, the firmware takes count/ms
+            device->serial.set_delta_encoding(cfg_.delta_commands,
+                                              cfg_.delta_threshold * cfg_.enc_counts_per_rev / (2.0 * M_PI) / 1000.0,
+                                              cfg_.keyframe_interval);
+            device->serial.set_servo_trajectory(cfg_.servo_trajectory, cfg_.servo_max_velocity,
+                                                static_cast<size_t>(cfg_.servo_trajectory_points));
+            devices_.push_back(std::move(device));
+        }
+        return true;
+    }
+
     std::vector<hardware_interface::StateInterface> DogBotSystemHardware::export_state_interfaces()
     {
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Exporting State Interfaces... please wait...");
 
         std::vector<hardware_interface::StateInterface> state_interfaces;
 
-        state_interfaces.emplace_back(wheel_lf_.name, hardware_interface::HW_IF_POSITION, &wheel_lf_.pos);
-        state_interfaces.emplace_back(wheel_rf_.name, hardware_interface::HW_IF_POSITION, &wheel_rf_.pos);
-        state_interfaces.emplace_back(wheel_lb_.name, hardware_interface::HW_IF_POSITION, &wheel_lb_.pos);
-        state_interfaces.emplace_back(wheel_rb_.name, hardware_interface::HW_IF_POSITION, &wheel_rb_.pos);
+        for (size_t i = 0; i < wheels_.size(); ++i)
+        {
+            state_interfaces.emplace_back(wheels_.name[i], hardware_interface::HW_IF_POSITION, &wheels_.pos[i]);
+            state_interfaces.emplace_back(wheels_.name[i], hardware_interface::HW_IF_VELOCITY, &wheels_.vel[i]);
+        }
 
-        state_interfaces.emplace_back(sonar_.name, "range", &sonar_.range);
+        for (size_t i = 0; i < sonars_.size(); ++i)
+        {
+            state_interfaces.emplace_back(sonars_.name[i], "range", &sonars_.range[i]);
+        }
+
+        state_interfaces.emplace_back(cfg_.link_name, "link_up", &link_up_state_);
+        state_interfaces.emplace_back(cfg_.link_name, "timestamp", &timestamp_);
+        state_interfaces.emplace_back(cfg_.link_name, "feedback_age", &feedback_age_);
+        for (const auto &[command, prefix] : EXPORTED_RTTS)
+        {
+            const std::string name(prefix);
+            state_interfaces.emplace_back(cfg_.link_name, name + "_rtt_p50", &link_health_.rtt_p50[command]);
+            state_interfaces.emplace_back(cfg_.link_name, name + "_rtt_p99", &link_health_.rtt_p99[command]);
+            state_interfaces.emplace_back(cfg_.link_name, name + "_rtt_max", &link_health_.rtt_max[command]);
+        }
+        state_interfaces.emplace_back(cfg_.link_name, "timeouts", &link_health_.timeouts);
+        state_interfaces.emplace_back(cfg_.link_name, "parse_errors", &link_health_.parse_errors);
+        state_interfaces.emplace_back(cfg_.link_name, "short_reads", &link_health_.short_reads);
+        state_interfaces.emplace_back(cfg_.link_name, "tx_bytes_per_s", &link_health_.tx_bytes_per_s);
+        state_interfaces.emplace_back(cfg_.link_name, "rx_bytes_per_s", &link_health_.rx_bytes_per_s);
 
         return state_interfaces;
     }
@@ -73,13 +570,15 @@ namespace dogbot_hardware
 
         std::vector<hardware_interface::CommandInterface> command_interfaces;
 
-        command_interfaces.emplace_back(wheel_lf_.name, hardware_interface::HW_IF_VELOCITY, &wheel_lf_.cmd);
-        command_interfaces.emplace_back(wheel_rf_.name, hardware_interface::HW_IF_VELOCITY, &wheel_rf_.cmd);
-        command_interfaces.emplace_back(wheel_lb_.name, hardware_interface::HW_IF_VELOCITY, &wheel_lb_.cmd);
-        command_interfaces.emplace_back(wheel_rb_.name, hardware_interface::HW_IF_VELOCITY, &wheel_rb_.cmd);
+        for (size_t i = 0; i < wheels_.size(); ++i)
+        {
+            command_interfaces.emplace_back(wheels_.name[i], hardware_interface::HW_IF_VELOCITY, &wheels_.cmd[i]);
+        }
 
-        command_interfaces.emplace_back(servo_forearm_.name, hardware_interface::HW_IF_POSITION, &servo_forearm_.cmd);
-        command_interfaces.emplace_back(servo_gripper_.name, hardware_interface::HW_IF_POSITION, &servo_gripper_.cmd);
+        for (size_t i = 0; i < servos_.size(); ++i)
+        {
+            command_interfaces.emplace_back(servos_.name[i], hardware_interface::HW_IF_POSITION, &servos_.cmd[i]);
+        }
 
         return command_interfaces;
     }
@@ -88,25 +587,36 @@ namespace dogbot_hardware
         const rclcpp_lifecycle::State & /*previous_state*/)
     {
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Configuring... please wait...");
-        if (serial_.connected())
-        {
-            RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Reconnecting...");
-            serial_.disconnect();
-        }
-        if (serial_.connect(cfg_.device, cfg_.baud_rate, cfg_.timeout_ms))
+        for (size_t i = 0; i < devices_.size(); ++i)
         {
-            RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Successfully configured!");
-            return hardware_interface::CallbackReturn::SUCCESS;
+            Serial &serial = devices_[i]->serial;
+            if (serial.connected())
+            {
+                RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Reconnecting %s...", cfg_.devices[i].c_str());
+                serial.disconnect();
+            }
+            if (!serial.connect(cfg_.devices[i], cfg_.baud_rate, cfg_.timeout_ms, cfg_.protocol))
+            {
+                RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to Configure %s!", cfg_.devices[i].c_str());
+                return hardware_interface::CallbackReturn::ERROR;
+            }
         }
-        RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to Configure!");
-        return hardware_interface::CallbackReturn::ERROR;
+        RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Successfully configured!");
+        return hardware_interface::CallbackReturn::SUCCESS;
     }
 
     hardware_interface::CallbackReturn DogBotSystemHardware::on_cleanup(
         const rclcpp_lifecycle::State & /*previous_state*/)
     {
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Cleaning... please wait...");
-        if (serial_.connected() && serial_.disconnect())
+        stop_io_thread();
+        stop_reconnect_threads();
+        bool cleaned_up = true;
+        for (const auto &device : devices_)
+        {
+            cleaned_up = device->serial.connected() && device->serial.disconnect() && cleaned_up;
+        }
+        if (cleaned_up)
         {
             RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Successfully cleaned up!");
             return hardware_interface::CallbackReturn::SUCCESS;
@@ -119,10 +629,69 @@ namespace dogbot_hardware
         const rclcpp_lifecycle::State & /*previous_state*/)
     {
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Activating ...please wait...");
-        if (!serial_.connected())
+        stop_reconnect_threads();
+        has_feedback_ = false;
+        wheels_.reset_velocities();
+        link_health_ = LinkHealth();
+        link_health_.window_start = std::chrono::steady_clock::now();
+        read_jitter_.configure(static_cast<size_t>(cfg_.jitter_cycles));
+        write_jitter_.configure(static_cast<size_t>(cfg_.jitter_cycles));
+        io_jitter_.configure(static_cast<size_t>(cfg_.jitter_cycles));
+        if (cfg_.lock_memory)
         {
-            RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to activate!");
-            return hardware_interface::CallbackReturn::ERROR;
+            try
+            {
+                dogbot_realtime::lock_memory();
+            }
+            catch (const std::exception &e)
+            {
+                RCLCPP_WARN(rclcpp::get_logger("DogBotSystemHardware"), "Unable to lock memory: %s", e.what());
+            }
+        }
+        for (const auto &device : devices_)
+        {
+            if (!device->serial.connected())
+            {
+                RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to activate!");
+                return hardware_interface::CallbackReturn::ERROR;
+            }
+            device->failed_cycles = 0;
+            device->fresh = false;
+            device->sonar_countdown = 0;
+            device->has_applied = false;
+            device->link_up.store(true, std::memory_order_release);
+            device->rebase_pending.store(false, std::memory_order_relaxed);
+            device->serial.stats().reset();
+            if (cfg_.stream_rate > 0)
+            {
+                try
+                {
+                    device->serial.stream(static_cast<uint16_t>(cfg_.stream_rate));
+                }
+                catch (const std::exception &e)
+                {
+                    RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to start telemetry stream: %s", e.what());
+                    return hardware_interface::CallbackReturn::ERROR;
+                }
+            }
+        }
+        if (cfg_.async_io)
+        {
+            start_io_thread();
+        }
+        else if (exchanges_whole_cycle())
+        {
+            // prime the feedback consumed by the first read() of the batched cycle
+            make_cycle_commands();
+            exchange();
+            for (const auto &device : devices_)
+            {
+                if (device->failed_cycles > 0)
+                {
+                    RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to activate!");
+                    return hardware_interface::CallbackReturn::ERROR;
+                }
+            }
         }
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Successfully activated!");
 
@@ -132,6 +701,23 @@ namespace dogbot_hardware
     hardware_interface::CallbackReturn DogBotSystemHardware::on_deactivate(
         const rclcpp_lifecycle::State & /*previous_state*/)
     {
+        stop_io_thread();
+        stop_reconnect_threads();
+        for (const auto &device : devices_)
+        {
+            if (device->link_up.load(std::memory_order_acquire) && device->serial.connected() &&
+                device->serial.streaming())
+            {
+                try
+                {
+                    device->serial.stream(0);
+                }
+                catch (const std::exception &e)
+                {
+                    RCLCPP_WARN(rclcpp::get_logger("DogBotSystemHardware"), "Failed to stop telemetry stream: %s", e.what());
+                }
+            }
+        }
 
         return hardware_interface::CallbackReturn::SUCCESS;
         RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Deactivating ...please wait...");
@@ -143,26 +729,68 @@ namespace dogbot_hardware
     hardware_interface::return_type DogBotSystemHardware::read(
         const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
     {
-        if (!serial_.connected())
+        if (read_jitter_.complete())
         {
-            RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Failed to read!");
-            return hardware_interface::return_type::ERROR;
+            report_jitter(*logger_, "read()", read_jitter_);
         }
-        try
+        const dogbot_realtime::JitterRecorder::Cycle cycle(read_jitter_);
+
+        if (!cfg_.async_io)
         {
-            serial_.read_feedback(wheel_lf_.enc, wheel_rf_.enc, wheel_lb_.enc, wheel_rb_.enc);
-            serial_.read_sonar(sonar_.range);
+            if (!devices_open())
+            {
+                logger_->log(READ_FAILED);
+                return hardware_interface::return_type::ERROR;
+            }
+            if (cfg_.stream_rate > 0)
+            {
+                collect_telemetry();
+            }
+            else if (!exchanges_whole_cycle())
+            {
+                collect_feedback();
+            }
+            // otherwise feedback was collected by the round-trip of the previous write()
         }
-        catch (const std::exception &e)
+
+        for (size_t i = 0; i < devices_.size(); ++i)
         {
-            RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to read feedback data: %s", e.what());
-            return hardware_interface::return_type::ERROR;
+            Device &device = *devices_[i];
+            CycleFeedback feedback;
+            if (cfg_.async_io)
+            {
+                if (device.feedback_queue.pop_latest(feedback))
+                {
+                    apply_feedback(i, feedback);
+                }
+            }
+            else if (device.fresh)
+            {
+                apply_feedback(i, device.feedback);
+                device.fresh = false;
+            }
         }
+        wheels_.update();
 
-        wheel_lf_.update();
-        wheel_rf_.update();
-        wheel_lb_.update();
-        wheel_rb_.update();
+        if (has_feedback_)
+        {
+            feedback_age_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - feedback_stamp_).count();
+            timestamp_ = std::chrono::duration<double>(feedback_stamp_.time_since_epoch()).count();
+        }
+        else
+        {
+            feedback_age_ = std::numeric_limits<double>::infinity();
+            timestamp_ = std::numeric_limits<double>::quiet_NaN();
+        }
+        link_up_state_ = 1.0;
+        for (const auto &device : devices_)
+        {
+            if (!device->link_up.load(std::memory_order_acquire))
+            {
+                link_up_state_ = 0.0;
+            }
+        }
+        update_link_health();
 
         return hardware_interface::return_type::OK;
     }
@@ -170,30 +798,533 @@ namespace dogbot_hardware
     hardware_interface::return_type dogbot_hardware::DogBotSystemHardware::write(
         const rclcpp::Time & /*time*/, const rclcpp::Duration & /*period*/)
     {
-        if (!serial_.connected())
+        if (write_jitter_.complete())
+        {
+            report_jitter(*logger_, "write()", write_jitter_);
+        }
+        const dogbot_realtime::JitterRecorder::Cycle cycle(write_jitter_);
+
+        if (cfg_.async_io)
+        {
+            // a full ring means the worker is behind; it will pick up the next cycle's command
+            wheels_.calculate_command_speeds();
+            for (size_t i = 0; i < devices_.size(); ++i)
+            {
+                devices_[i]->command_queue.push(make_cycle_command(i));
+            }
+            return hardware_interface::return_type::OK;
+        }
+
+        if (!devices_open())
         {
             return hardware_interface::return_type::ERROR;
         }
 
-        double motor_lf_speed = wheel_lf_.calculate_command_speed();
-        double motor_rf_speed = wheel_rf_.calculate_command_speed();
-        double motor_lb_speed = wheel_lb_.calculate_command_speed();
-        double motor_rb_speed = wheel_rb_.calculate_command_speed();
+        // devices whose link is down are skipped; they get fresh commands once they are back
+        make_cycle_commands();
+        if (cfg_.stream_rate == 0 && exchanges_whole_cycle())
+        {
+            exchange_all(cfg_.batched ? Serial::Exchange::BATCHED : Serial::Exchange::PIPELINED,
+                         "Failed to exchange cycle data");
+        }
+        else
+        {
+            exchange_all(Serial::Exchange::COMMANDS, "Failed to set command values");
+        }
+        return hardware_interface::return_type::OK;
+    }
+
+    CycleCommand DogBotSystemHardware::make_cycle_command(size_t device) const
+    {
+        CycleCommand command;
+        for (size_t i = 0; i < wheels_.size(); ++i)
+        {
+            if (wheels_.device[i] == device)
+            {
+                command.motor_speed[wheels_.channel[i]] = wheels_.speed[i];
+            }
+        }
+        for (size_t i = 0; i < servos_.size(); ++i)
+        {
+            if (servos_.device[i] == device)
+            {
+                command.servo_position[servos_.channel[i]] = servos_.get_position(i);
+            }
+        }
+        return command;
+    }
+
+    void DogBotSystemHardware::make_cycle_commands()
+    {
+        wheels_.calculate_command_speeds();
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            devices_[i]->command = make_cycle_command(i);
+        }
+    }
+
+    void DogBotSystemHardware::apply_feedback(size_t device, const CycleFeedback &feedback)
+    {
+        // the first sample of a new session restarts the firmware's counters; older samples
+        // may still arrive while waiting for it
+        Device &source = *devices_[device];
+        const bool rebase = source.rebase_pending.load(std::memory_order_acquire) &&
+                            feedback.stamp.time_since_epoch().count() >=
+                                source.session_start.load(std::memory_order_relaxed);
+        // velocities are differentiated over the firmware's sample interval rather than the
+        // control period, so late or skipped cycles do not show up as speed changes
+        const double dt = source.has_applied
+                              ? std::chrono::duration<double>(feedback.stamp - source.applied_stamp).count()
+                              : 0.0;
+        const double gain = cfg_.velocity_filter_cutoff > 0.0
+                                ? 1.0 - std::exp(-2.0 * M_PI * cfg_.velocity_filter_cutoff * dt)
+                                : 1.0;
+        if (dt >= 0.0)
+        {
+            source.applied_stamp = feedback.stamp;
+            source.has_applied = true;
+        }
+        for (size_t i = 0; i < wheels_.size(); ++i)
+        {
+            if (wheels_.device[i] == device)
+            {
+                const auto enc = static_cast<double>(feedback.enc[wheels_.channel[i]]);
+                if (rebase)
+                {
+                    wheels_.rebase(i, enc);
+                }
+                wheels_.sample(i, enc, dt, gain);
+            }
+        }
+        if (rebase)
+        {
+            source.rebase_pending.store(false, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < sonars_.size(); ++i)
+        {
+            if (sonars_.device[i] == device && feedback.has_range)
+            {
+                sonars_.range[i] = feedback.range;
+            }
+        }
+
+        if (device == stamp_device_)
+        {
+            feedback_stamp_ = feedback.stamp;
+            has_feedback_ = true;
+        }
+    }
+
+    bool DogBotSystemHardware::exchanges_whole_cycle() const
+    {
+        return cfg_.batched || cfg_.pipelined;
+    }
+
+    bool DogBotSystemHardware::sonar_due(Device &device) const
+    {
+        if (!device.reads_sonar)
+        {
+            return false;
+        }
+        if (device.sonar_countdown > 0)
+        {
+            --device.sonar_countdown;
+            return false;
+        }
+        device.sonar_countdown = cfg_.sonar_interval - 1;
+        return true;
+    }
+
+    void DogBotSystemHardware::exchange()
+    {
+        if (cfg_.stream_rate > 0)
+        {
+            exchange_all(Serial::Exchange::COMMANDS, "Failed to set command values");
+            collect_telemetry();
+        }
+        else if (cfg_.batched)
+        {
+            exchange_all(Serial::Exchange::BATCHED, "Failed to exchange cycle data");
+        }
+        else if (cfg_.pipelined)
+        {
+            exchange_all(Serial::Exchange::PIPELINED, "Failed to exchange cycle data");
+        }
+        else
+        {
+            exchange_all(Serial::Exchange::COMMANDS, "Failed to set command values");
+            collect_feedback();
+        }
+    }
+
+    void DogBotSystemHardware::exchange_all(Serial::Exchange exchange, const char *what)
+    {
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            Device &device = *devices_[i];
+            device.in_flight = false;
+            if (!device.link_up.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            try
+            {
+                device.serial.begin_exchange(exchange, device.command,
+                                             exchange != Serial::Exchange::COMMANDS && sonar_due(device));
+                device.in_flight = true;
+            }
+            catch (const std::exception &e)
+            {
+                link_failed(i, what, e);
+            }
+        }
+
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            Device &device = *devices_[i];
+            if (!device.in_flight)
+            {
+                continue;
+            }
+            device.in_flight = false;
+            try
+            {
+                CycleFeedback feedback;
+                device.serial.finish_exchange(feedback);
+                link_succeeded(i);
+                if (exchange != Serial::Exchange::COMMANDS)
+                {
+                    device.feedback = feedback;
+                    device.fresh = true;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                link_failed(i, what, e);
+            }
+        }
+    }
+
+    void DogBotSystemHardware::collect_feedback()
+    {
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            Device &device = *devices_[i];
+            if (!(device.reads_encoders || device.reads_sonar) || !device.link_up.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            try
+            {
+                CycleFeedback feedback;
+                if (device.reads_encoders)
+                {
+                    device.serial.read_feedback(feedback.enc[0], feedback.enc[1], feedback.enc[2], feedback.enc[3]);
+                    feedback.stamp = device.serial.sample_stamp();
+                }
+                else
+                {
+                    feedback.stamp = std::chrono::steady_clock::now();
+                }
+                if (sonar_due(device))
+                {
+                    device.serial.read_sonar(feedback.range);
+                    feedback.has_range = true;
+                }
+                link_succeeded(i);
+                device.feedback = feedback;
+                device.fresh = true;
+            }
+            catch (const std::exception &e)
+            {
+                link_failed(i, "Failed to read feedback data", e);
+            }
+        }
+    }
 
-        int servo_gripper_pos = servo_gripper_.get_position();
-        int servo_forearm_pos = servo_forearm_.get_position();
+    void DogBotSystemHardware::collect_telemetry()
+    {
+        for (size_t i = 0; i < devices_.size(); ++i)
+        {
+            Device &device = *devices_[i];
+            if (!device.link_up.load(std::memory_order_acquire))
+            {
+                continue;
+            }
+            try
+            {
+                if (device.serial.poll_telemetry(device.feedback))
+                {
+                    device.fresh = true;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                link_failed(i, "Failed to read telemetry", e);
+            }
+        }
+    }
 
+    bool DogBotSystemHardware::devices_open() const
+    {
+        for (const auto &device : devices_)
+        {
+            if (device->link_up.load(std::memory_order_acquire) && !device->serial.connected())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void DogBotSystemHardware::start_io_thread()
+    {
+        stop_io_thread();
+
+        // drop anything left over from a previous activation
+        for (const auto &device : devices_)
+        {
+            CycleCommand stale_command;
+            device->command_queue.pop_latest(stale_command);
+            CycleFeedback stale_feedback;
+            device->feedback_queue.pop_latest(stale_feedback);
+        }
+
+        make_cycle_commands();
+        if (!cfg_.io_profile.cpus.empty())
+        {
+            try
+            {
+                default_cpus_ = dogbot_realtime::process_cpus();
+            }
+            catch (const std::exception &e)
+            {
+                RCLCPP_WARN(rclcpp::get_logger("DogBotSystemHardware"), "Unable to read the CPU affinity: %s", e.what());
+                default_cpus_.clear();
+            }
+        }
+        io_running_.store(true, std::memory_order_release);
+        io_thread_ = std::thread(&DogBotSystemHardware::io_loop, this);
+    }
+
+    void DogBotSystemHardware::stop_io_thread()
+    {
+        io_running_.store(false, std::memory_order_release);
+        if (io_thread_.joinable())
+        {
+            io_thread_.join();
+        }
+    }
+
+    void DogBotSystemHardware::io_loop()
+    {
         try
         {
-            serial_.set_motor_speed(motor_lf_speed, motor_rf_speed, motor_lb_speed, motor_rb_speed);
-            serial_.set_servo_position(servo_forearm_pos, servo_gripper_pos);
+            dogbot_realtime::apply_thread_profile(cfg_.io_profile);
         }
         catch (const std::exception &e)
         {
-            RCLCPP_ERROR(rclcpp::get_logger("DogBotSystemHardware"), "Failed to set command values: %s", e.what());
-            return hardware_interface::return_type::ERROR;
+            logger_->log(IO_PROFILE_FAILED, e.what());
+        }
+
+        const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / cfg_.io_rate));
+        auto next_cycle = std::chrono::steady_clock::now();
+
+        while (io_running_.load(std::memory_order_acquire))
+        {
+            if (io_jitter_.complete())
+            {
+                report_jitter(*logger_, "I/O worker", io_jitter_);
+            }
+            {
+                const dogbot_realtime::JitterRecorder::Cycle cycle(io_jitter_);
+                for (const auto &device : devices_)
+                {
+                    device->command_queue.pop_latest(device->command);
+                }
+                exchange();
+                for (const auto &device : devices_)
+                {
+                    if (device->fresh)
+                    {
+                        device->feedback_queue.push(device->feedback);
+                        device->fresh = false;
+                    }
+                }
+            }
+
+            // skip missed cycles instead of bursting to catch up after a slow reply
+            next_cycle += period;
+            const auto now = std::chrono::steady_clock::now();
+            if (next_cycle < now)
+            {
+                next_cycle = now;
+            }
+            std::this_thread::sleep_until(next_cycle);
+        }
+    }
+
+    void DogBotSystemHardware::link_succeeded(size_t device)
+    {
+        if (devices_[device]->failed_cycles > 0)
+        {
+            logger_->log(LINK_RECOVERED, cfg_.devices[device]);
+            devices_[device]->failed_cycles = 0;
+        }
+    }
+
+    void DogBotSystemHardware::link_failed(size_t device, const char *what, const std::exception &e)
+    {
+        int &failed_cycles = devices_[device]->failed_cycles;
+        // only the first failure of a run is logged
+        if (failed_cycles++ == 0)
+        {
+            logger_->log(LINK_FAILED, what, cfg_.devices[device], e.what());
+        }
+        if (failed_cycles < cfg_.link_failure_limit)
+        {
+            return;
+        }
+
+        logger_->log(LINK_DOWN, cfg_.devices[device], failed_cycles);
+        failed_cycles = 0;
+        devices_[device]->link_up.store(false, std::memory_order_release);
+        start_reconnect_thread(device);
+    }
+
+    void DogBotSystemHardware::reconnect(size_t device)
+    {
+        // started by the I/O worker, whose real-time priority and CPUs a blocking reconnect must not share
+        if (cfg_.io_profile.priority > 0)
+        {
+            try
+            {
+                dogbot_realtime::set_thread_priority(0);
+            }
+            catch (const std::exception &)
+            {
+            }
+        }
+        if (!default_cpus_.empty())
+        {
+            try
+            {
+                dogbot_realtime::pin_thread(default_cpus_);
+            }
+            catch (const std::exception &)
+            {
+            }
+        }
+        Serial &serial = devices_[device]->serial;
+        const std::atomic<bool> &keep_running = devices_[device]->reconnect_running;
+        double delay = cfg_.reconnect_min_delay;
+        while (keep_running.load(std::memory_order_acquire))
+        {
+            const auto attempt_start = std::chrono::steady_clock::now();
+            if (serial.connected())
+            {
+                serial.disconnect();
+            }
+            if (serial.connect(cfg_.devices[device], cfg_.baud_rate, cfg_.timeout_ms, cfg_.protocol))
+            {
+                try
+                {
+                    if (cfg_.stream_rate > 0)
+                    {
+                        serial.stream(static_cast<uint16_t>(cfg_.stream_rate));
+                    }
+                    devices_[device]->session_start.store(attempt_start.time_since_epoch().count(),
+                                                          std::memory_order_relaxed);
+                    devices_[device]->rebase_pending.store(true, std::memory_order_release);
+                    devices_[device]->link_up.store(true, std::memory_order_release);
+                    RCLCPP_INFO(rclcpp::get_logger("DogBotSystemHardware"), "Serial link to %s re-established",
+                                cfg_.devices[device].c_str());
+                    return;
+                }
+                catch (const std::exception &e)
+                {
+                    RCLCPP_WARN(rclcpp::get_logger("DogBotSystemHardware"), "Failed to restart telemetry stream: %s", e.what());
+                }
+            }
+
+            // back off exponentially, waking up early when asked to stop
+            const auto retry = attempt_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                   std::chrono::duration<double>(delay));
+            while (keep_running.load(std::memory_order_acquire) && std::chrono::steady_clock::now() < retry)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            delay = std::min(delay * 2.0, cfg_.reconnect_max_delay);
+        }
+    }
+
+    void DogBotSystemHardware::start_reconnect_thread(size_t device)
+    {
+        // a previous worker of this device has already raised link_up and is about to exit
+        if (devices_[device]->reconnect_thread.joinable())
+        {
+            devices_[device]->reconnect_thread.join();
+        }
+        devices_[device]->reconnect_running.store(true, std::memory_order_release);
+        devices_[device]->reconnect_thread = std::thread(&DogBotSystemHardware::reconnect, this, device);
+    }
+
+    void DogBotSystemHardware::stop_reconnect_threads()
+    {
+        for (const auto &device : devices_)
+        {
+            device->reconnect_running.store(false, std::memory_order_release);
+        }
+        for (const auto &device : devices_)
+        {
+            if (device->reconnect_thread.joinable())
+            {
+                device->reconnect_thread.join();
+            }
+        }
+    }
+
+    void DogBotSystemHardware::update_link_health()
+    {
+        for (const auto &entry : EXPORTED_RTTS)
+        {
+            link_health_.rtt_p50[entry.first] = 0.0;
+            link_health_.rtt_p99[entry.first] = 0.0;
+            link_health_.rtt_max[entry.first] = 0.0;
+        }
+        uint64_t timeouts = 0, parse_errors = 0, short_reads = 0, tx_bytes = 0, rx_bytes = 0;
+        for (const auto &device : devices_)
+        {
+            const LinkStats &stats = device->serial.stats();
+            for (const auto &entry : EXPORTED_RTTS)
+            {
+                const RttHistogram &histogram = stats.rtt[entry.first];
+                link_health_.rtt_p50[entry.first] = std::max(link_health_.rtt_p50[entry.first], histogram.percentile(0.5));
+                link_health_.rtt_p99[entry.first] = std::max(link_health_.rtt_p99[entry.first], histogram.percentile(0.99));
+                link_health_.rtt_max[entry.first] = std::max(link_health_.rtt_max[entry.first], histogram.max());
+            }
+            timeouts += stats.timeouts.load(std::memory_order_relaxed);
+            parse_errors += stats.parse_errors.load(std::memory_order_relaxed);
+            short_reads += stats.short_reads.load(std::memory_order_relaxed);
+            tx_bytes += stats.tx_bytes.load(std::memory_order_relaxed);
+            rx_bytes += stats.rx_bytes.load(std::memory_order_relaxed);
+        }
+        link_health_.timeouts = static_cast<double>(timeouts);
+        link_health_.parse_errors = static_cast<double>(parse_errors);
+        link_health_.short_reads = static_cast<double>(short_reads);
+
+        // byte rates are averaged over windows of at least a second so they do not flicker
+        const auto now = std::chrono::steady_clock::now();
+        const double window = std::chrono::duration<double>(now - link_health_.window_start).count();
+        if (window >= 1.0)
+        {
+            link_health_.tx_bytes_per_s = static_cast<double>(tx_bytes - link_health_.window_tx_bytes) / window;
+            link_health_.rx_bytes_per_s = static_cast<double>(rx_bytes - link_health_.window_rx_bytes) / window;
+            link_health_.window_tx_bytes = tx_bytes;
+            link_health_.window_rx_bytes = rx_bytes;
+            link_health_.window_start = now;
         }
-        return hardware_interface::return_type::OK;
     }
 } // namespace dogbot_hardware
 
@@ -0,0 +1,194 @@
+#ifndef DOGBOT_HARDWARE_CAPTURE_LOG_HPP
+#define DOGBOT_HARDWARE_CAPTURE_LOG_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace dogbot_hardware
+{
+    // Binary log of the traffic on a serial link. The file is a CaptureHeader followed by records,
+    // each a CaptureRecord and its bytes padded to a multiple of 8, so a reader can map the file
+    // and walk it in place. Integers are stored in host byte order.
+    namespace capture
+    {
+        constexpr char MAGIC[8] = {'D', 'B', 'C', 'A', 'P', 'T', 'R', '1'};
+
+        enum class Direction : uint8_t
+        {
+            TX = 0,    // host to board
+            RX = 1,    // board to host
+            OPEN = 2,  // the port was (re)opened; no bytes
+            CLOCK = 3, // the host read the port's clock; no bytes
+        };
+
+        struct CaptureHeader
+        {
+            char magic[8];
+            int64_t start_ns; // steady clock when the capture began
+        };
+
+        struct CaptureRecord
+        {
+            int64_t stamp_ns; // since start_ns
+            uint32_t length;  // bytes following the record, before padding
+            Direction direction;
+            uint8_t reserved[3];
+        };
+
+        static_assert(sizeof(CaptureHeader) == 16 && sizeof(CaptureRecord) == 16, "capture layout is fixed");
+
+        inline size_t padded(size_t length)
+        {
+            return (length + 7) & ~static_cast<size_t>(7);
+        }
+
+        inline int64_t to_ns(std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+    } // namespace capture
+
+    // Appends records to a capture file. Writes go through a large stdio buffer, so a record
+    // normally costs a copy; the buffer reaches the disk when it fills and when the writer closes.
+    class CaptureWriter
+    {
+    public:
+        explicit CaptureWriter(const std::string &path)
+        {
+            file_ = std::fopen(path.c_str(), "wb");
+            if (file_ == nullptr)
+            {
+                throw std::runtime_error("unable to create " + path + ": " + std::strerror(errno));
+            }
+            std::setvbuf(file_, nullptr, _IOFBF, 1 << 16);
+            capture::CaptureHeader header{};
+            std::memcpy(header.magic, capture::MAGIC, sizeof(header.magic));
+            header.start_ns = start_ns_ = capture::to_ns(std::chrono::steady_clock::now());
+            std::fwrite(&header, sizeof(header), 1, file_);
+        }
+
+        ~CaptureWriter()
+        {
+            std::fclose(file_);
+        }
+
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        // Appends a record stamped `stamp_ns` on the steady clock.
+        void append(capture::Direction direction, int64_t stamp_ns, const uint8_t *data, size_t length)
+        {
+            static const uint8_t padding[8] = {};
+            capture::CaptureRecord record{};
+            record.stamp_ns = stamp_ns - start_ns_;
+            record.length = static_cast<uint32_t>(length);
+            record.direction = direction;
+            std::fwrite(&record, sizeof(record), 1, file_);
+            if (length > 0)
+            {
+                std::fwrite(data, 1, length, file_);
+                std::fwrite(padding, 1, capture::padded(length) - length, file_);
+            }
+        }
+
+        void flush()
+        {
+            std::fflush(file_);
+        }
+
+    private:
+        std::FILE *file_ = nullptr;
+        int64_t start_ns_ = 0;
+    };
+
+    // A capture file mapped read-only. Records are visited in order through a cursor, an offset
+    // into the file; a file cut short by a crash ends at its last complete record.
+    class CaptureReader
+    {
+    public:
+        explicit CaptureReader(const std::string &path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+            }
+            struct stat status{};
+            if (::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(capture::CaptureHeader))
+            {
+                size_ = static_cast<size_t>(status.st_size);
+                void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                data_ = data == MAP_FAILED ? nullptr : static_cast<const uint8_t *>(data);
+            }
+            ::close(fd);
+            if (data_ == nullptr ||
+                std::memcmp(reinterpret_cast<const capture::CaptureHeader *>(data_)->magic, capture::MAGIC,
+                            sizeof(capture::MAGIC)) != 0)
+            {
+                unmap();
+                throw std::runtime_error(path + " is not a serial capture");
+            }
+        }
+
+        ~CaptureReader()
+        {
+            unmap();
+        }
+
+        CaptureReader(const CaptureReader &) = delete;
+        CaptureReader &operator=(const CaptureReader &) = delete;
+
+        // Cursor of the first record.
+        size_t begin() const
+        {
+            return sizeof(capture::CaptureHeader);
+        }
+
+        // The record at `cursor`, or nullptr past the last one.
+        const capture::CaptureRecord *record(size_t cursor) const
+        {
+            if (cursor + sizeof(capture::CaptureRecord) > size_)
+            {
+                return nullptr;
+            }
+            const auto *record = reinterpret_cast<const capture::CaptureRecord *>(data_ + cursor);
+            return cursor + sizeof(*record) + record->length <= size_ ? record : nullptr;
+        }
+
+        const uint8_t *bytes(size_t cursor) const
+        {
+            return data_ + cursor + sizeof(capture::CaptureRecord);
+        }
+
+        size_t next(size_t cursor) const
+        {
+            return cursor + sizeof(capture::CaptureRecord) + capture::padded(record(cursor)->length);
+        }
+
+    private:
+        void unmap()
+        {
+            if (data_ != nullptr)
+            {
+                ::munmap(const_cast<uint8_t *>(data_), size_);
+                data_ = nullptr;
+            }
+        }
+
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_CAPTURE_LOG_HPP
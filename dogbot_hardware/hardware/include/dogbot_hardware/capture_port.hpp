@@ -0,0 +1,123 @@
+#ifndef DOGBOT_HARDWARE_CAPTURE_PORT_HPP
+#define DOGBOT_HARDWARE_CAPTURE_PORT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dogbot_hardware/capture_log.hpp"
+#include "dogbot_hardware/port.hpp"
+
+namespace dogbot_hardware
+{
+    // Port that records the traffic through another one into a capture file for ReplayPort.
+    // Every write becomes a TX record. Received bytes, which Serial reads one at a time, are
+    // gathered into one RX record per burst, stamped with its last byte: a burst ends at the next
+    // write, at a short read, at a clock reading, or when a read comes more than a millisecond
+    // after the previous byte. The clock readings Serial stamps the traffic with are recorded
+    // too, so that a replay can hand back the very same ones.
+    class CapturePort : public Port
+    {
+    public:
+        CapturePort(std::unique_ptr<Port> port, const std::string &path)
+            : port_(std::move(port)), writer_(path)
+        {
+            rx_.reserve(256);
+        }
+
+        ~CapturePort() override
+        {
+            end_burst();
+        }
+
+        void open(const std::string &device, uint32_t baud_rate, uint32_t timeout_ms) override
+        {
+            port_->open(device, baud_rate, timeout_ms);
+            end_burst();
+            writer_.append(capture::Direction::OPEN, capture::to_ns(port_->now()), nullptr, 0);
+        }
+
+        void close() override
+        {
+            port_->close();
+            end_burst();
+            writer_.flush();
+        }
+
+        bool is_open() const override
+        {
+            return port_->is_open();
+        }
+
+        size_t read(uint8_t *data, size_t length) override
+        {
+            const size_t count = port_->read(data, length);
+            const int64_t now = capture::to_ns(port_->now());
+            if (!rx_.empty() && now - rx_last_ns_ > BURST_GAP_NS)
+            {
+                end_burst();
+            }
+            rx_.insert(rx_.end(), data, data + count);
+            rx_last_ns_ = now;
+            if (count < length)
+            {
+                end_burst();
+            }
+            return count;
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            end_burst();
+            writer_.append(capture::Direction::TX, capture::to_ns(port_->now()), data, length);
+            return port_->write(data, length);
+        }
+
+        size_t available() override
+        {
+            return port_->available();
+        }
+
+        void flush() override
+        {
+            port_->flush();
+        }
+
+        void flush_input() override
+        {
+            end_burst();
+            port_->flush_input();
+        }
+
+        std::chrono::steady_clock::time_point now() override
+        {
+            end_burst();
+            const auto now = port_->now();
+            writer_.append(capture::Direction::CLOCK, capture::to_ns(now), nullptr, 0);
+            return now;
+        }
+
+    private:
+        static constexpr int64_t BURST_GAP_NS = 1000000;
+
+        void end_burst()
+        {
+            if (!rx_.empty())
+            {
+                writer_.append(capture::Direction::RX, rx_last_ns_, rx_.data(), rx_.size());
+                rx_.clear();
+            }
+        }
+
+        std::unique_ptr<Port> port_;
+        CaptureWriter writer_;
+        std::vector<uint8_t> rx_; // bytes of the burst being received
+        int64_t rx_last_ns_ = 0;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_CAPTURE_PORT_HPP
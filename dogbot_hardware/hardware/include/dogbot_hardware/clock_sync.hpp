@@ -0,0 +1,140 @@
+#ifndef DOGBOT_HARDWARE_CLOCK_SYNC_HPP
+#define DOGBOT_HARDWARE_CLOCK_SYNC_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace dogbot_hardware
+{
+    // Maps timestamps of the firmware's free-running 32-bit microsecond clock onto the host's
+    // steady clock.
+    //
+    // Every observation pairs an MCU timestamp with the host time its frame was received, which
+    // bounds the clock offset (host minus MCU time) from above: the sample was taken no later than
+    // it arrived. The tightest bound of each BUCKET_NS of MCU time is kept for the last BUCKETS
+    // buckets; a least-squares line through them gives the relative clock rate, and the line is
+    // then lowered onto the lowest of them. Serial latency jitter therefore barely moves the
+    // estimate, while a crystal running a few thousand ppm off is still tracked.
+    class ClockSync
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t BUCKETS = 16;
+        static constexpr int64_t BUCKET_NS = 250000000;
+        static constexpr double MAX_RATE_ERROR = 0.01;
+
+        // Records an MCU timestamp received at host time `received` and returns the host time
+        // at which the MCU took it.
+        Clock::time_point observe(uint32_t mcu_us, Clock::time_point received)
+        {
+            const int32_t step_us = static_cast<int32_t>(mcu_us - last_raw_us_);
+            last_raw_us_ = mcu_us;
+            // a large backward step means the firmware restarted, e.g. when the port was reopened
+            if (!synced_ || step_us < -RESTART_THRESHOLD_US)
+            {
+                synced_ = true;
+                mcu_ns_ = 0;
+                newest_ = 0;
+                for (auto &bucket : buckets_)
+                {
+                    bucket.used = false;
+                }
+            }
+            else
+            {
+                mcu_ns_ += static_cast<int64_t>(step_us) * 1000;
+            }
+
+            const int64_t bound_ns = received.time_since_epoch().count() - mcu_ns_;
+            const int64_t index = std::max<int64_t>(mcu_ns_, 0) / BUCKET_NS;
+            while (newest_ < index)
+            {
+                buckets_[++newest_ % BUCKETS].used = false;
+            }
+            Bucket &bucket = buckets_[index % BUCKETS];
+            if (index == newest_ && (!bucket.used || bound_ns < bucket.bound_ns))
+            {
+                bucket = {true, mcu_ns_, bound_ns};
+            }
+
+            const int64_t host_ns = mcu_ns_ + offset_at(mcu_ns_);
+            return std::min(received, Clock::time_point(Clock::duration(host_ns)));
+        }
+
+        void reset()
+        {
+            synced_ = false;
+        }
+
+        bool synced() const
+        {
+            return synced_;
+        }
+
+    private:
+        static_assert(std::is_same_v<Clock::duration, std::chrono::nanoseconds>,
+                      "ClockSync assumes a nanosecond steady clock");
+
+        static constexpr int32_t RESTART_THRESHOLD_US = 1000000;
+
+        struct Bucket
+        {
+            bool used = false;
+            int64_t mcu_ns = 0;
+            int64_t bound_ns = 0;
+        };
+
+        // Lower envelope of the kept bounds, evaluated at MCU time `mcu_ns`.
+        int64_t offset_at(int64_t mcu_ns) const
+        {
+            // work relative to the evaluation point to keep the doubles well conditioned
+            const Bucket &newest = buckets_[newest_ % BUCKETS];
+            double count = 0.0, sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0;
+            for (const auto &bucket : buckets_)
+            {
+                if (bucket.used)
+                {
+                    const auto x = static_cast<double>(bucket.mcu_ns - mcu_ns);
+                    const auto y = static_cast<double>(bucket.bound_ns - newest.bound_ns);
+                    count += 1.0;
+                    sum_x += x;
+                    sum_y += y;
+                    sum_xx += x * x;
+                    sum_xy += x * y;
+                }
+            }
+            double slope = 0.0;
+            const double spread = count * sum_xx - sum_x * sum_x;
+            if (count >= 2.0 && spread > 0.0)
+            {
+                slope = std::clamp((count * sum_xy - sum_x * sum_y) / spread, -MAX_RATE_ERROR, MAX_RATE_ERROR);
+            }
+
+            double lowest = 0.0;
+            bool first = true;
+            for (const auto &bucket : buckets_)
+            {
+                if (bucket.used)
+                {
+                    const double shifted = static_cast<double>(bucket.bound_ns - newest.bound_ns) -
+                                           slope * static_cast<double>(bucket.mcu_ns - mcu_ns);
+                    lowest = first ? shifted : std::min(lowest, shifted);
+                    first = false;
+                }
+            }
+            return newest.bound_ns + static_cast<int64_t>(lowest);
+        }
+
+        bool synced_ = false;
+        uint32_t last_raw_us_ = 0;
+        int64_t mcu_ns_ = 0; // MCU time since the first observation, unwrapped
+        int64_t newest_ = 0; // index of the bucket holding mcu_ns_
+        Bucket buckets_[BUCKETS];
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_CLOCK_SYNC_HPP
@@ -0,0 +1,95 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DOGBOT_HARDWARE_DOGBOT_IMU_HPP_
+#define DOGBOT_HARDWARE_DOGBOT_IMU_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dogbot_hardware/visibility_control.h"
+#include "hardware_interface/handle.hpp"
+#include "hardware_interface/hardware_info.hpp"
+#include "hardware_interface/sensor_interface.hpp"
+#include "hardware_interface/types/hardware_interface_return_values.hpp"
+#include "rclcpp/duration.hpp"
+#include "rclcpp/macros.hpp"
+#include "rclcpp/time.hpp"
+#include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
+#include "rclcpp_lifecycle/state.hpp"
+
+#include "dogbot_hardware/i2c_bus.hpp"
+#include "dogbot_hardware/icm20948.hpp"
+#include "dogbot_realtime/realtime_logger.hpp"
+
+namespace dogbot_hardware {
+    // ICM-20948 on a Linux I2C adapter. Each read() drains the chip's FIFO in burst transfers and
+    // exports the mean of the accel and gyro samples taken since the previous read(), a decimation
+    // that keeps the chip's full rate for noise averaging, and the newest magnetometer sample.
+    class DogBotImuHardware : public hardware_interface::SensorInterface {
+
+        struct Config {
+            std::string i2c_bus;
+            Icm20948::Config imu;
+        };
+
+    public:
+        RCLCPP_SHARED_PTR_DEFINITIONS(DogBotImuHardware);
+
+        DOGBOT_HARDWARE_PUBLIC
+        hardware_interface::CallbackReturn on_init(
+                const hardware_interface::HardwareInfo &info) override;
+
+        DOGBOT_HARDWARE_PUBLIC
+        std::vector<hardware_interface::StateInterface> export_state_interfaces() override;
+
+        DOGBOT_HARDWARE_PUBLIC
+        hardware_interface::CallbackReturn on_configure(
+                const rclcpp_lifecycle::State &previous_state) override;
+
+        DOGBOT_HARDWARE_PUBLIC
+        hardware_interface::CallbackReturn on_cleanup(
+                const rclcpp_lifecycle::State &previous_state) override;
+
+        DOGBOT_HARDWARE_PUBLIC
+        hardware_interface::CallbackReturn on_activate(
+                const rclcpp_lifecycle::State &previous_state) override;
+
+        DOGBOT_HARDWARE_PUBLIC
+        hardware_interface::return_type read(
+                const rclcpp::Time &time, const rclcpp::Duration &period) override;
+
+    private:
+        // Storage of the state interface called `name`, nullptr if there is none by that name.
+        double *find_state(const std::string &name);
+
+        // Takes the messages of read(), which must not block on the RCLCPP logger.
+        std::unique_ptr<dogbot_realtime::RealtimeLogger> logger_;
+        Config cfg_;
+        std::unique_ptr<I2cBus> bus_;
+        std::unique_ptr<Icm20948> imu_;
+
+        double accel_[3] = {0.0, 0.0, 0.0}; // [m/s^2]
+        double gyro_[3] = {0.0, 0.0, 0.0};  // [rad/s]
+        double mag_[3] = {0.0, 0.0, 0.0};   // [T]
+        // the chip estimates no orientation; report identity and mark it unknown through the
+        // broadcaster's orientation covariance
+        double orientation_[4] = {0.0, 0.0, 0.0, 1.0};
+        double fifo_overflows_ = 0.0;
+    };
+
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_DOGBOT_IMU_HPP_
@@ -15,8 +15,12 @@
 #ifndef DOGBOT_HARDWARE_DOGBOT_SYSTEM_HPP_
 #define DOGBOT_HARDWARE_DOGBOT_SYSTEM_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "dogbot_hardware/visibility_control.h"
@@ -31,24 +35,118 @@
 #include "rclcpp_lifecycle/node_interfaces/lifecycle_node_interface.hpp"
 #include "rclcpp_lifecycle/state.hpp"
 
+#include "dogbot_realtime/jitter_recorder.hpp"
+#include "dogbot_realtime/realtime_logger.hpp"
+#include "dogbot_realtime/thread_profile.hpp"
+
+#include "dogbot_hardware/capture_port.hpp"
+#include "dogbot_hardware/joint_tables.hpp"
+#include "dogbot_hardware/loopback_port.hpp"
+#include "dogbot_hardware/replay_port.hpp"
 #include "dogbot_hardware/serial.hpp"
-#include "dogbot_hardware/wheel.hpp"
-#include "dogbot_hardware/servo.hpp"
-#include "dogbot_hardware/sonar.hpp"
+#include "dogbot_hardware/spsc_queue.hpp"
 
 namespace dogbot_hardware {
     class DogBotSystemHardware : public hardware_interface::SystemInterface {
 
         struct Config {
-            std::string device;
+            std::vector<std::string> devices;
             int baud_rate = 0;
             int timeout_ms = 1000;
             int enc_counts_per_rev = 0;
+            Protocol protocol = Protocol::ASCII;
+            bool batched = false;
+            bool pipelined = false;
+            int stream_rate = 0;
+            bool async_io = false;
+            double io_rate = 20.0;
+            dogbot_realtime::ThreadProfile io_profile; // of the I/O worker
+            bool lock_memory = false;
+            int jitter_cycles = 0; // [cycles] per timing report of read(), write() and the I/O worker, 0 for none
+            int sonar_interval = 1; // [cycles] between sonar pings
+            bool delta_commands = false;
+            double delta_threshold = 0.01; // [rad/s]
+            int keyframe_interval = 20;
+            bool servo_trajectory = false;
+            double servo_max_velocity = 180.0; // [deg/s]
+            int servo_trajectory_points = 4;
+            double velocity_filter_cutoff = 0.0; // [Hz] of the wheel velocity low-pass, 0 to disable
+            int link_failure_limit = 3;
+            double reconnect_min_delay = 0.1; // [s]
+            double reconnect_max_delay = 2.0; // [s]
+            std::string link_name = "serial_link";
+            // in-process plant replacing the boards, see LoopbackPort
+            bool mock = false;
+            double mock_motor_time_constant = 0.05; // [s]
+            double mock_wall_distance = 1.0;        // [m] ahead of the sonar at start
+            double mock_wheel_radius = 0.04;        // [m]
+            // serial traffic recorded to, or replayed from, a capture file per board
+            std::string capture_file;
+            std::string replay_file;
+            double replay_speed = 1.0; // 0 replays as fast as the loop runs
+        };
+
+        // One microcontroller on its own serial port.
+        struct Device
+        {
+            Serial serial;
+            bool reads_encoders = false;
+            bool reads_sonar = false;
+
+            // Owned by whichever thread drives serial: the I/O worker with `async_io`, otherwise
+            // the control thread. The worker trades commands and feedback through the queues.
+            CycleCommand command;
+            CycleFeedback feedback;
+            bool fresh = false;     // feedback arrived and has not been applied yet
+            bool in_flight = false; // an exchange was begun on it and is still to be finished
+            int sonar_countdown = 0; // cycles until the sonar is pinged again
+            SpscQueue<CycleCommand, 16> command_queue;
+            SpscQueue<CycleFeedback, 16> feedback_queue;
+
+            // Link supervision. After `link_failure_limit` failed cycles in a row the link is marked
+            // down and reconnect_thread reopens the port; it owns serial until it raises link_up again.
+            // Meanwhile the other devices carry on.
+            int failed_cycles = 0;
+            std::atomic<bool> link_up{true};
+            std::thread reconnect_thread;
+            std::atomic<bool> reconnect_running{false};
+
+            // A reconnect restarts the firmware's encoder counts, so the wheels on this board are
+            // rebased on its first sample taken after session_start.
+            std::atomic<bool> rebase_pending{false};
+            std::atomic<std::chrono::steady_clock::rep> session_start{0};
+
+            // Control thread only: sample time of the last feedback applied, the start of the
+            // interval the next one's wheel velocities are differentiated over.
+            std::chrono::steady_clock::time_point applied_stamp;
+            bool has_applied = false;
+        };
+
+        // Snapshot of the devices' link stats exported through the link's state interfaces: the
+        // slowest device's round-trip times, since a cycle waits for all of them, and summed counters.
+        struct LinkHealth
+        {
+            double rtt_p50[LinkStats::COMMAND_COUNT] = {}; // [s]
+            double rtt_p99[LinkStats::COMMAND_COUNT] = {}; // [s]
+            double rtt_max[LinkStats::COMMAND_COUNT] = {}; // [s]
+            double timeouts = 0.0;
+            double parse_errors = 0.0;
+            double short_reads = 0.0;
+            double tx_bytes_per_s = 0.0;
+            double rx_bytes_per_s = 0.0;
+
+            // byte counters at the start of the current rate window
+            uint64_t window_tx_bytes = 0;
+            uint64_t window_rx_bytes = 0;
+            std::chrono::steady_clock::time_point window_start;
         };
 
     public:
         RCLCPP_SHARED_PTR_DEFINITIONS(DogBotSystemHardware);
 
+        DOGBOT_HARDWARE_PUBLIC
+        ~DogBotSystemHardware() override;
+
         DOGBOT_HARDWARE_PUBLIC
         hardware_interface::CallbackReturn on_init(
                 const hardware_interface::HardwareInfo &info) override;
@@ -84,15 +182,87 @@ namespace dogbot_hardware {
                 const rclcpp::Time &time, const rclcpp::Duration &period) override;
 
     private:
-        Serial serial_;
+        // Builds the joint tables and devices_ from the joints and sensors in info_.
+        bool register_components();
+
+        // Assembles the device's share of the commands; wheels_.speed must be up to date.
+        CycleCommand make_cycle_command(size_t device) const;
+
+        // Stores the command of every device in Device::command, for the thread driving them.
+        void make_cycle_commands();
+
+        void apply_feedback(size_t device, const CycleFeedback &feedback);
+
+        bool exchanges_whole_cycle() const;
+
+        // True if the device has a sonar due for a ping this cycle, which it then counts as done.
+        bool sonar_due(Device &device) const;
+
+        // Runs one control cycle on every device whose link is up, leaving what each reports in
+        // its Device::feedback. Failures are handled per device.
+        void exchange();
+
+        // Begins `exchange` on every device before finishing it on any, so the round-trips overlap
+        // and a cycle takes as long as the slowest link rather than the sum of them.
+        void exchange_all(Serial::Exchange exchange, const char *what);
+
+        // Reads encoders and sonar from the devices they are wired to, one request at a time.
+        void collect_feedback();
+
+        void collect_telemetry();
+
+        // False if a device whose link is up has had its port closed under it.
+        bool devices_open() const;
+
+        void start_io_thread();
+
+        void stop_io_thread();
+
+        void io_loop();
+
+        void update_link_health();
+
+        // Called by whichever thread drives the device's serial after each exchange.
+        void link_succeeded(size_t device);
+
+        void link_failed(size_t device, const char *what, const std::exception &e);
+
+        // Reopens the device's port with exponential backoff until the handshake succeeds or its
+        // reconnect_running is cleared. Runs on the device's reconnect_thread.
+        void reconnect(size_t device);
+
+        void start_reconnect_thread(size_t device);
+
+        void stop_reconnect_threads();
+
+        // Takes the messages of the control loop and the serial links, which must not block on the
+        // RCLCPP logger; declared first so that it outlives the links logging to it.
+        std::unique_ptr<dogbot_realtime::RealtimeLogger> logger_;
+        std::vector<std::unique_ptr<Device>> devices_;
         Config cfg_;
-        Wheel wheel_lf_;
-        Wheel wheel_rf_;
-        Wheel wheel_lb_;
-        Wheel wheel_rb_;
-        Servo servo_gripper_;
-        Servo servo_forearm_;
-        Sonar sonar_;
+        WheelTable wheels_;
+        ServoTable servos_;
+        SonarTable sonars_;
+        size_t stamp_device_ = 0; // board whose sample time is exported, that of the wheels
+        std::chrono::steady_clock::time_point feedback_stamp_;
+        bool has_feedback_ = false;
+        double feedback_age_ = 0.0;
+        double timestamp_ = std::numeric_limits<double>::quiet_NaN(); // [s] steady clock time at which feedback_ was sampled by the firmware
+        LinkHealth link_health_;
+
+        // Serial I/O worker used when `async_io` is enabled; it is the only user of the devices whose
+        // link is up while running.
+        std::thread io_thread_;
+        std::atomic<bool> io_running_{false};
+        std::vector<int> default_cpus_; // of the process, taken before the I/O worker is pinned
+
+        // Timing of the control loop's read() and write() and of the I/O worker's cycles, each
+        // owned by the thread running it; see `jitter_cycles`.
+        dogbot_realtime::JitterRecorder read_jitter_;
+        dogbot_realtime::JitterRecorder write_jitter_;
+        dogbot_realtime::JitterRecorder io_jitter_;
+
+        double link_up_state_ = 1.0; // 1 while every device's link is up
     };
 
 } // namespace dogbot_hardware
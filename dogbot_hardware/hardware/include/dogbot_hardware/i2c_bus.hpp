@@ -0,0 +1,109 @@
+#ifndef DOGBOT_HARDWARE_I2C_BUS_HPP
+#define DOGBOT_HARDWARE_I2C_BUS_HPP
+
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace dogbot_hardware
+{
+    // Register access to the devices on an I2C bus. Drivers only talk to this interface, so a
+    // virtual device can stand in for the real bus. Failed transfers throw std::runtime_error.
+    class I2cBus
+    {
+    public:
+        virtual ~I2cBus() = default;
+
+        // Writes `length` bytes to the device at `address`, starting at register `reg`.
+        virtual void write(uint8_t address, uint8_t reg, const uint8_t *data, size_t length) = 0;
+
+        // Reads `length` bytes from the device at `address`, starting at register `reg`, in one
+        // transfer; registers that auto-increment or stream, like a FIFO port, are read in a burst.
+        virtual void read(uint8_t address, uint8_t reg, uint8_t *data, size_t length) = 0;
+
+        void write_byte(uint8_t address, uint8_t reg, uint8_t value)
+        {
+            write(address, reg, &value, 1);
+        }
+
+        uint8_t read_byte(uint8_t address, uint8_t reg)
+        {
+            uint8_t value = 0;
+            read(address, reg, &value, 1);
+            return value;
+        }
+    };
+
+    // An adapter of the Linux i2c-dev driver such as /dev/i2c-0. Every transfer is a single
+    // I2C_RDWR ioctl; a read is the register address write and a repeated-start read of the whole
+    // burst, so draining a FIFO costs one system call however many bytes it holds.
+    class LinuxI2cBus : public I2cBus
+    {
+    public:
+        static constexpr size_t MAX_WRITE_SIZE = 32;
+
+        explicit LinuxI2cBus(const std::string &path)
+        {
+            fd_ = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+            if (fd_ < 0)
+            {
+                throw std::runtime_error("unable to open " + path + ": " + std::strerror(errno));
+            }
+        }
+
+        ~LinuxI2cBus() override
+        {
+            ::close(fd_);
+        }
+
+        LinuxI2cBus(const LinuxI2cBus &) = delete;
+        LinuxI2cBus &operator=(const LinuxI2cBus &) = delete;
+
+        void write(uint8_t address, uint8_t reg, const uint8_t *data, size_t length) override
+        {
+            if (length > MAX_WRITE_SIZE)
+            {
+                throw std::invalid_argument("I2C write too long");
+            }
+            uint8_t buffer[MAX_WRITE_SIZE + 1];
+            buffer[0] = reg;
+            std::memcpy(buffer + 1, data, length);
+            i2c_msg message{address, 0, static_cast<uint16_t>(length + 1), buffer};
+            transfer(&message, 1);
+        }
+
+        void read(uint8_t address, uint8_t reg, uint8_t *data, size_t length) override
+        {
+            if (length > UINT16_MAX)
+            {
+                throw std::invalid_argument("I2C read too long");
+            }
+            i2c_msg messages[2] = {{address, 0, 1, &reg},
+                                   {address, I2C_M_RD, static_cast<uint16_t>(length), data}};
+            transfer(messages, 2);
+        }
+
+    private:
+        void transfer(i2c_msg *messages, uint32_t count)
+        {
+            i2c_rdwr_ioctl_data request{messages, count};
+            if (::ioctl(fd_, I2C_RDWR, &request) < 0)
+            {
+                throw std::runtime_error(std::string("I2C transfer failed: ") + std::strerror(errno));
+            }
+        }
+
+        int fd_ = -1;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_I2C_BUS_HPP
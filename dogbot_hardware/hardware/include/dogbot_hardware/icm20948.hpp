@@ -0,0 +1,352 @@
+#ifndef DOGBOT_HARDWARE_ICM20948_HPP
+#define DOGBOT_HARDWARE_ICM20948_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "dogbot_hardware/i2c_bus.hpp"
+
+namespace dogbot_hardware
+{
+    namespace icm20948
+    {
+        // Register map, banks selected through REG_BANK_SEL.
+        constexpr uint8_t REG_BANK_SEL = 0x7F;
+
+        // bank 0
+        constexpr uint8_t WHO_AM_I = 0x00;
+        constexpr uint8_t USER_CTRL = 0x03;
+        constexpr uint8_t PWR_MGMT_1 = 0x06;
+        constexpr uint8_t PWR_MGMT_2 = 0x07;
+        constexpr uint8_t I2C_MST_STATUS = 0x17;
+        constexpr uint8_t FIFO_EN_1 = 0x66;
+        constexpr uint8_t FIFO_EN_2 = 0x67;
+        constexpr uint8_t FIFO_RST = 0x68;
+        constexpr uint8_t FIFO_MODE = 0x69;
+        constexpr uint8_t FIFO_COUNTH = 0x70;
+        constexpr uint8_t FIFO_R_W = 0x72;
+
+        // bank 2
+        constexpr uint8_t GYRO_SMPLRT_DIV = 0x00;
+        constexpr uint8_t GYRO_CONFIG_1 = 0x01;
+        constexpr uint8_t ODR_ALIGN_EN = 0x09;
+        constexpr uint8_t ACCEL_SMPLRT_DIV_1 = 0x10;
+        constexpr uint8_t ACCEL_SMPLRT_DIV_2 = 0x11;
+        constexpr uint8_t ACCEL_CONFIG = 0x14;
+
+        // bank 3, the auxiliary I2C master wired to the magnetometer
+        constexpr uint8_t I2C_MST_ODR_CONFIG = 0x00;
+        constexpr uint8_t I2C_MST_CTRL = 0x01;
+        constexpr uint8_t I2C_SLV0_ADDR = 0x03;
+        constexpr uint8_t I2C_SLV0_REG = 0x04;
+        constexpr uint8_t I2C_SLV0_CTRL = 0x05;
+        constexpr uint8_t I2C_SLV4_ADDR = 0x13;
+        constexpr uint8_t I2C_SLV4_REG = 0x14;
+        constexpr uint8_t I2C_SLV4_CTRL = 0x15;
+        constexpr uint8_t I2C_SLV4_DO = 0x16;
+        constexpr uint8_t I2C_SLV4_DI = 0x17;
+
+        constexpr uint8_t CHIP_ID = 0xEA;
+        constexpr uint8_t USER_CTRL_FIFO_EN = 0x40;
+        constexpr uint8_t USER_CTRL_I2C_MST_EN = 0x20;
+        constexpr uint8_t I2C_SLV_EN = 0x80;
+        constexpr uint8_t I2C_SLV_READ = 0x80;
+        constexpr uint8_t I2C_SLV4_DONE = 0x40;
+
+        // AK09916 magnetometer behind the auxiliary master
+        constexpr uint8_t MAG_ADDRESS = 0x0C;
+        constexpr uint8_t MAG_WIA2 = 0x01;
+        constexpr uint8_t MAG_HXL = 0x11;
+        constexpr uint8_t MAG_CNTL2 = 0x31;
+        constexpr uint8_t MAG_CNTL3 = 0x32;
+        constexpr uint8_t MAG_ID = 0x09;
+        constexpr uint8_t MAG_CONTINUOUS_100HZ = 0x08;
+        constexpr uint8_t MAG_ST2_HOFL = 0x08;
+        constexpr double MAG_TESLA_PER_COUNT = 0.15e-6;
+
+        // The FIFO holds ACCEL_XOUT_H..ACCEL_ZOUT_L and GYRO_XOUT_H..GYRO_ZOUT_L, big endian, then
+        // the eight magnetometer bytes HXL..ST2 fetched by SLV0, little endian.
+        constexpr size_t MAG_BLOCK_SIZE = 8;
+        constexpr size_t PACKET_SIZE = 12 + MAG_BLOCK_SIZE;
+        constexpr size_t FIFO_SIZE = 512;
+
+        constexpr double INTERNAL_RATE = 1125.0; // [Hz] sample rate at a divider of 0
+        constexpr double STANDARD_GRAVITY = 9.80665;
+    } // namespace icm20948
+
+    // One ICM-20948 sample in SI units, all axes in the accelerometer's frame.
+    struct ImuSample
+    {
+        double accel[3] = {0.0, 0.0, 0.0}; // [m/s^2]
+        double gyro[3] = {0.0, 0.0, 0.0};  // [rad/s]
+        double mag[3] = {0.0, 0.0, 0.0};   // [T]
+        bool mag_valid = false;            // false if the magnetometer reported an overflow
+    };
+
+    // Driver of the ICM-20948 that reads the chip through its FIFO. The chip samples accel and gyro
+    // at the configured rate and its auxiliary I2C master copies the magnetometer into the same
+    // FIFO packet, so one burst read returns every sample taken since the last one.
+    class Icm20948
+    {
+    public:
+        struct Config
+        {
+            uint8_t address = 0x68;
+            double sample_rate = 225.0; // [Hz], rounded to 1125 Hz / integer
+            int accel_range = 4;        // [g] full scale: 2, 4, 8 or 16
+            int gyro_range = 500;       // [deg/s] full scale: 250, 500, 1000 or 2000
+            size_t max_burst = 240;     // [bytes] per read transfer, rounded down to whole packets
+        };
+
+        Icm20948(I2cBus &bus, const Config &config)
+            : bus_(bus), config_(config)
+        {
+            const size_t packets = std::max<size_t>(config_.max_burst / icm20948::PACKET_SIZE, 1);
+            buffer_.resize(packets * icm20948::PACKET_SIZE);
+        }
+
+        static bool valid_accel_range(int range)
+        {
+            return range == 2 || range == 4 || range == 8 || range == 16;
+        }
+
+        static bool valid_gyro_range(int range)
+        {
+            return range == 250 || range == 500 || range == 1000 || range == 2000;
+        }
+
+        // Resets the chip, checks it and its magnetometer are present, programs ranges and rate
+        // and starts filling the FIFO. Throws on failure.
+        void configure()
+        {
+            using namespace icm20948;
+            if (!valid_accel_range(config_.accel_range) || !valid_gyro_range(config_.gyro_range))
+            {
+                throw std::invalid_argument("unsupported ICM-20948 full scale range");
+            }
+
+            bank_ = -1;
+            select_bank(0);
+            write(PWR_MGMT_1, 0x80);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            bank_ = -1;
+            select_bank(0);
+            write(PWR_MGMT_1, 0x01); // wake up on the best available clock
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            if (read(WHO_AM_I) != CHIP_ID)
+            {
+                throw std::runtime_error("no ICM-20948 at the configured address");
+            }
+            write(PWR_MGMT_2, 0x00);
+
+            const auto divider = static_cast<uint8_t>(
+                std::clamp(std::lround(INTERNAL_RATE / config_.sample_rate) - 1, 0L, 255L));
+            sample_rate_ = INTERNAL_RATE / (divider + 1);
+            const uint8_t dlpf = low_pass_config(sample_rate_);
+            const uint8_t accel_fs = static_cast<uint8_t>(std::log2(config_.accel_range) - 1);
+            const uint8_t gyro_fs = static_cast<uint8_t>(std::log2(config_.gyro_range / 250));
+            accel_scale_ = config_.accel_range * STANDARD_GRAVITY / 32768.0;
+            gyro_scale_ = config_.gyro_range * M_PI / 180.0 / 32768.0;
+
+            select_bank(2);
+            write(GYRO_SMPLRT_DIV, divider);
+            write(GYRO_CONFIG_1, static_cast<uint8_t>((dlpf << 3) | (gyro_fs << 1) | 0x01));
+            write(ACCEL_SMPLRT_DIV_1, 0x00);
+            write(ACCEL_SMPLRT_DIV_2, divider);
+            write(ACCEL_CONFIG, static_cast<uint8_t>((dlpf << 3) | (accel_fs << 1) | 0x01));
+            write(ODR_ALIGN_EN, 0x01);
+
+            select_bank(0);
+            write(USER_CTRL, USER_CTRL_I2C_MST_EN);
+            select_bank(3);
+            write(I2C_MST_CTRL, 0x07); // 345.6 kHz
+            write(I2C_MST_ODR_CONFIG, 0x04);
+            if (mag_read(MAG_WIA2) != MAG_ID)
+            {
+                throw std::runtime_error("no AK09916 magnetometer behind the ICM-20948");
+            }
+            mag_write(MAG_CNTL3, 0x01);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            mag_write(MAG_CNTL2, MAG_CONTINUOUS_100HZ);
+            select_bank(3);
+            write(I2C_SLV0_ADDR, I2C_SLV_READ | MAG_ADDRESS);
+            write(I2C_SLV0_REG, MAG_HXL);
+            write(I2C_SLV0_CTRL, I2C_SLV_EN | MAG_BLOCK_SIZE);
+
+            select_bank(0);
+            write(FIFO_EN_1, 0x01);  // SLV0
+            write(FIFO_EN_2, 0x1E);  // accel, gyro x/y/z
+            write(FIFO_MODE, 0x01); // snapshot: stop writing when full instead of splitting packets
+            write(USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_I2C_MST_EN);
+            reset_fifo();
+        }
+
+        // Discards everything queued in the FIFO.
+        void reset_fifo()
+        {
+            using namespace icm20948;
+            select_bank(0);
+            write(FIFO_RST, 0x1F);
+            write(FIFO_RST, 0x00);
+        }
+
+        // Drains the FIFO in bursts of whole packets and calls `on_sample(const ImuSample &)` for
+        // each, oldest first. Returns the number of samples read. A full FIFO has stopped taking
+        // samples; what it holds is still delivered, then it is reset and counted in overflows().
+        template <typename OnSample>
+        size_t read_fifo(OnSample &&on_sample)
+        {
+            using namespace icm20948;
+            select_bank(0);
+            uint8_t count_bytes[2];
+            bus_.read(config_.address, FIFO_COUNTH, count_bytes, sizeof(count_bytes));
+            const size_t count = (static_cast<size_t>(count_bytes[0] & 0x1F) << 8) | count_bytes[1];
+            const bool full = count > FIFO_SIZE - PACKET_SIZE;
+
+            size_t remaining = count - count % PACKET_SIZE;
+            size_t samples = 0;
+            while (remaining > 0)
+            {
+                const size_t burst = std::min(remaining, buffer_.size());
+                bus_.read(config_.address, FIFO_R_W, buffer_.data(), burst);
+                for (size_t offset = 0; offset < burst; offset += PACKET_SIZE)
+                {
+                    on_sample(decode(buffer_.data() + offset));
+                    ++samples;
+                }
+                remaining -= burst;
+            }
+            if (full)
+            {
+                reset_fifo();
+                ++overflows_;
+            }
+            return samples;
+        }
+
+        // Rate [Hz] the chip actually samples at, once configured.
+        double sample_rate() const
+        {
+            return sample_rate_;
+        }
+
+        uint64_t overflows() const
+        {
+            return overflows_;
+        }
+
+    private:
+        // Largest digital low-pass setting whose bandwidth, for accel and gyro alike, stays below
+        // the Nyquist frequency of `rate`.
+        static uint8_t low_pass_config(double rate)
+        {
+            // 3 dB bandwidths [Hz] of DLPFCFG 1..6, the lower of the accel and gyro filters
+            constexpr double BANDWIDTH[] = {151.8, 111.4, 50.4, 23.9, 11.5, 5.7};
+            for (uint8_t i = 0; i < 6; ++i)
+            {
+                if (BANDWIDTH[i] < rate / 2.0)
+                {
+                    return static_cast<uint8_t>(i + 1);
+                }
+            }
+            return 6;
+        }
+
+        static int16_t big_endian(const uint8_t *in)
+        {
+            return static_cast<int16_t>((in[0] << 8) | in[1]);
+        }
+
+        static int16_t little_endian(const uint8_t *in)
+        {
+            return static_cast<int16_t>(in[0] | (in[1] << 8));
+        }
+
+        ImuSample decode(const uint8_t *packet) const
+        {
+            using namespace icm20948;
+            ImuSample sample;
+            for (int i = 0; i < 3; ++i)
+            {
+                sample.accel[i] = big_endian(packet + 2 * i) * accel_scale_;
+                sample.gyro[i] = big_endian(packet + 6 + 2 * i) * gyro_scale_;
+            }
+            // the AK09916's y and z axes point opposite to the accelerometer's
+            const uint8_t *mag = packet + 12;
+            sample.mag[0] = little_endian(mag) * MAG_TESLA_PER_COUNT;
+            sample.mag[1] = -little_endian(mag + 2) * MAG_TESLA_PER_COUNT;
+            sample.mag[2] = -little_endian(mag + 4) * MAG_TESLA_PER_COUNT;
+            sample.mag_valid = (mag[7] & MAG_ST2_HOFL) == 0;
+            return sample;
+        }
+
+        void select_bank(int bank)
+        {
+            if (bank != bank_)
+            {
+                bus_.write_byte(config_.address, icm20948::REG_BANK_SEL, static_cast<uint8_t>(bank << 4));
+                bank_ = bank;
+            }
+        }
+
+        void write(uint8_t reg, uint8_t value)
+        {
+            bus_.write_byte(config_.address, reg, value);
+        }
+
+        uint8_t read(uint8_t reg)
+        {
+            return bus_.read_byte(config_.address, reg);
+        }
+
+        // Runs a single-byte transfer on the auxiliary bus through SLV4 and waits for it.
+        void mag_transfer(uint8_t address, uint8_t reg, uint8_t value)
+        {
+            using namespace icm20948;
+            select_bank(3);
+            write(I2C_SLV4_ADDR, address);
+            write(I2C_SLV4_REG, reg);
+            write(I2C_SLV4_DO, value);
+            write(I2C_SLV4_CTRL, I2C_SLV_EN);
+            select_bank(0);
+            for (int attempt = 0; attempt < 50; ++attempt)
+            {
+                if (read(I2C_MST_STATUS) & I2C_SLV4_DONE)
+                {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            throw std::runtime_error("ICM-20948 auxiliary I2C transfer timed out");
+        }
+
+        void mag_write(uint8_t reg, uint8_t value)
+        {
+            mag_transfer(icm20948::MAG_ADDRESS, reg, value);
+        }
+
+        uint8_t mag_read(uint8_t reg)
+        {
+            mag_transfer(icm20948::I2C_SLV_READ | icm20948::MAG_ADDRESS, reg, 0);
+            select_bank(3);
+            return read(icm20948::I2C_SLV4_DI);
+        }
+
+        I2cBus &bus_;
+        Config config_;
+        int bank_ = -1; // bank REG_BANK_SEL is known to hold, -1 if unknown
+        double sample_rate_ = 0.0;
+        double accel_scale_ = 0.0; // [m/s^2 per count]
+        double gyro_scale_ = 0.0;  // [rad/s per count]
+        uint64_t overflows_ = 0;
+        std::vector<uint8_t> buffer_;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_ICM20948_HPP
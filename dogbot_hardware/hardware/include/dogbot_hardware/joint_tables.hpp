@@ -0,0 +1,167 @@
+#ifndef DOGBOT_HARDWARE_JOINT_TABLES_HPP
+#define DOGBOT_HARDWARE_JOINT_TABLES_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace dogbot_hardware
+{
+    // Wheels driven by a motor with an encoder, stored as structure-of-arrays: every quantity
+    // has its own contiguous buffer, so the conversions between encoder counts and radians run
+    // as single loops the compiler can vectorise. The buffers are sized once by add(); the state
+    // and command interfaces point into them.
+    class WheelTable
+    {
+    public:
+        std::vector<std::string> name;
+        std::vector<size_t> device;     // index of the board the wheel is wired to
+        std::vector<size_t> channel;    // motor channel on that board
+        std::vector<double> cmd;        // [rad/s]
+        std::vector<double> pos;        // [rad]
+        std::vector<double> vel;        // [rad/s] differentiated from the encoder samples
+        std::vector<double> enc;        // [count] as last reported by the firmware
+        std::vector<double> enc_offset; // [count] keeps pos continuous across firmware restarts
+        std::vector<double> speed;      // [count/ms] motor speed sent to the firmware
+        std::vector<double> sample_rate; // [1/s] inverse interval to the previous sample, 0 if no new one
+        std::vector<double> sample_gain; // low-pass filter gain for the new sample, 0 if no new one
+
+        void setup(int enc_counts_per_rev)
+        {
+            rad_per_count_ = (2.0 * M_PI) / static_cast<double>(enc_counts_per_rev);
+        }
+
+        void add(const std::string &wheel_name, size_t wheel_device, size_t wheel_channel)
+        {
+            name.push_back(wheel_name);
+            device.push_back(wheel_device);
+            channel.push_back(wheel_channel);
+            cmd.push_back(0.0);
+            pos.push_back(0.0);
+            vel.push_back(0.0);
+            enc.push_back(0.0);
+            enc_offset.push_back(0.0);
+            speed.push_back(0.0);
+            sample_rate.push_back(0.0);
+            sample_gain.push_back(0.0);
+        }
+
+        size_t size() const
+        {
+            return name.size();
+        }
+
+        // Records the wheel's encoder count sampled `dt` seconds after its previous sample; a
+        // non-positive `dt` marks a sample with no usable predecessor. update() moves vel towards
+        // the finite difference by `gain`, 1 leaving it unfiltered.
+        void sample(size_t wheel, double counts, double dt, double gain)
+        {
+            enc[wheel] = counts;
+            sample_rate[wheel] = dt > 0.0 ? 1.0 / dt : 0.0;
+            sample_gain[wheel] = dt > 0.0 ? gain : 0.0;
+        }
+
+        // Converts the encoder counts of every wheel into positions, and differentiates those
+        // sampled since the last call into velocities. Wheels without a new sample keep theirs.
+        void update()
+        {
+            const size_t count = size();
+            const double *counts = enc.data();
+            const double *offsets = enc_offset.data();
+            double *positions = pos.data();
+            double *velocities = vel.data();
+            double *rates = sample_rate.data();
+            double *gains = sample_gain.data();
+            for (size_t i = 0; i < count; ++i)
+            {
+                const double position = (counts[i] + offsets[i]) * rad_per_count_;
+                const double raw = (position - positions[i]) * rates[i];
+                velocities[i] += gains[i] * (raw - velocities[i]);
+                positions[i] = position;
+                rates[i] = 0.0;
+                gains[i] = 0.0;
+            }
+        }
+
+        void reset_velocities()
+        {
+            std::fill(vel.begin(), vel.end(), 0.0);
+            std::fill(sample_rate.begin(), sample_rate.end(), 0.0);
+            std::fill(sample_gain.begin(), sample_gain.end(), 0.0);
+        }
+
+        // Keeps the wheel's pos continuous when the firmware restarts counting from `first_enc`,
+        // as it does when the serial port is reopened.
+        void rebase(size_t wheel, double first_enc)
+        {
+            enc_offset[wheel] += enc[wheel] - first_enc;
+        }
+
+        // Converts the velocity command of every wheel into a motor speed.
+        void calculate_command_speeds()
+        {
+            const size_t count = size();
+            const double count_per_ms = 1.0 / rad_per_count_ / 1000.0;
+            const double *commands = cmd.data();
+            double *speeds = speed.data();
+            for (size_t i = 0; i < count; ++i)
+            {
+                speeds[i] = commands[i] * count_per_ms;
+            }
+        }
+
+    private:
+        double rad_per_count_ = 0.0;
+    };
+
+    // Hobby servos commanded by angle.
+    struct ServoTable
+    {
+        std::vector<std::string> name;
+        std::vector<size_t> device;
+        std::vector<size_t> channel; // servo channel on the board
+        std::vector<double> cmd;     // [deg]
+
+        void add(const std::string &servo_name, size_t servo_device, size_t servo_channel, double initial_cmd)
+        {
+            name.push_back(servo_name);
+            device.push_back(servo_device);
+            channel.push_back(servo_channel);
+            cmd.push_back(initial_cmd);
+        }
+
+        size_t size() const
+        {
+            return name.size();
+        }
+
+        int get_position(size_t servo) const
+        {
+            return static_cast<int>(cmd[servo]);
+        }
+    };
+
+    // Ultrasonic range finders, at most one per board.
+    struct SonarTable
+    {
+        std::vector<std::string> name;
+        std::vector<size_t> device;
+        std::vector<double> range; // [m]
+
+        void add(const std::string &sonar_name, size_t sonar_device)
+        {
+            name.push_back(sonar_name);
+            device.push_back(sonar_device);
+            range.push_back(0.0);
+        }
+
+        size_t size() const
+        {
+            return name.size();
+        }
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_JOINT_TABLES_HPP
@@ -0,0 +1,157 @@
+#ifndef DOGBOT_HARDWARE_LINK_STATS_HPP
+#define DOGBOT_HARDWARE_LINK_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+namespace dogbot_hardware
+{
+    // Lock-free round-trip time histogram with power-of-two buckets: bucket 0 holds RTTs
+    // below 64 us, bucket b holds [64 us * 2^(b-1), 64 us * 2^b) and the last one is open ended.
+    class RttHistogram
+    {
+    public:
+        static constexpr size_t BUCKETS = 16;
+        static constexpr uint64_t FIRST_BUCKET_NS = 64000;
+
+        void record(uint64_t rtt_ns)
+        {
+            size_t bucket = 0;
+            for (uint64_t bound = FIRST_BUCKET_NS; rtt_ns >= bound && bucket < BUCKETS - 1; bound <<= 1)
+            {
+                ++bucket;
+            }
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+
+            uint64_t max = max_ns_.load(std::memory_order_relaxed);
+            while (rtt_ns > max && !max_ns_.compare_exchange_weak(max, rtt_ns, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        uint64_t count() const
+        {
+            return count_.load(std::memory_order_relaxed);
+        }
+
+        uint64_t bucket(size_t index) const
+        {
+            return buckets_[index].load(std::memory_order_relaxed);
+        }
+
+        double max() const
+        {
+            return static_cast<double>(max_ns_.load(std::memory_order_relaxed)) * 1e-9;
+        }
+
+        // Upper bound [s] of the bucket holding the given fraction of all samples.
+        double percentile(double fraction) const
+        {
+            const uint64_t total = count();
+            if (total == 0)
+            {
+                return 0.0;
+            }
+            const auto target = static_cast<uint64_t>(fraction * static_cast<double>(total));
+            uint64_t seen = 0;
+            for (size_t b = 0; b < BUCKETS - 1; ++b)
+            {
+                seen += bucket(b);
+                if (seen > target)
+                {
+                    return static_cast<double>(FIRST_BUCKET_NS << b) * 1e-9;
+                }
+            }
+            return max();
+        }
+
+        void reset()
+        {
+            for (auto &bucket : buckets_)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count_.store(0, std::memory_order_relaxed);
+            max_ns_.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<uint64_t> buckets_[BUCKETS] = {};
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> max_ns_{0};
+    };
+
+    // Health counters of the serial link. Written by whichever thread drives the Serial,
+    // read concurrently by the hardware component; every field is an independent relaxed atomic.
+    class LinkStats
+    {
+    public:
+        enum Command : size_t
+        {
+            SYNC,
+            ENCODERS,
+            SONAR,
+            MOTOR,
+            SERVO,
+            CYCLE,
+            STREAM,
+            OTHER,
+            COMMAND_COUNT
+        };
+
+        // Maps an ASCII command tag or binary message type byte to its histogram.
+        static Command command_from_tag(uint8_t tag)
+        {
+            switch (tag)
+            {
+            case 'S':
+                return SYNC;
+            case 'E':
+                return ENCODERS;
+            case 'U':
+                return SONAR;
+            case 'M':
+                return MOTOR;
+            case 'P':
+            case 'J':
+                return SERVO;
+            case 'C':
+                return CYCLE;
+            case 'T':
+                return STREAM;
+            default:
+                return OTHER;
+            }
+        }
+
+        RttHistogram rtt[COMMAND_COUNT];
+
+        std::atomic<uint64_t> timeouts{0};
+        std::atomic<uint64_t> parse_errors{0};
+        std::atomic<uint64_t> short_reads{0};
+        std::atomic<uint64_t> tx_bytes{0};
+        std::atomic<uint64_t> rx_bytes{0};
+
+        static void bump(std::atomic<uint64_t> &counter, uint64_t amount = 1)
+        {
+            counter.fetch_add(amount, std::memory_order_relaxed);
+        }
+
+        void reset()
+        {
+            for (auto &histogram : rtt)
+            {
+                histogram.reset();
+            }
+            for (auto *counter : {&timeouts, &parse_errors, &short_reads, &tx_bytes, &rx_bytes})
+            {
+                counter->store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_LINK_STATS_HPP
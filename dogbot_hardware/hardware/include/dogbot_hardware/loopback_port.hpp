@@ -0,0 +1,117 @@
+#ifndef DOGBOT_HARDWARE_LOOPBACK_PORT_HPP
+#define DOGBOT_HARDWARE_LOOPBACK_PORT_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>
+
+#include "dogbot_hardware/port.hpp"
+#include "dogbot_hardware/virtual_arduino.hpp"
+
+namespace dogbot_hardware
+{
+    // Port wired straight to an in-process VirtualArduino: requests are handled as they are
+    // written and their replies can be read at once, with neither wire time nor firmware time,
+    // so a whole control stack can run against it at kHz rates. The model advances with the
+    // steady clock and, like the PTY version, keeps its state when the port is reopened.
+    class LoopbackPort : public Port
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        VirtualArduino &arduino()
+        {
+            return arduino_;
+        }
+
+        void open(const std::string & /*device*/, uint32_t /*baud_rate*/, uint32_t timeout_ms) override
+        {
+            timeout_ = std::chrono::milliseconds(timeout_ms);
+            input_.clear();
+            last_ = Clock::now();
+            open_ = true;
+        }
+
+        void close() override
+        {
+            open_ = false;
+        }
+
+        bool is_open() const override
+        {
+            return open_;
+        }
+
+        size_t read(uint8_t *data, size_t length) override
+        {
+            if (input_.size() < length)
+            {
+                advance();
+                // only streamed telemetry is ever waited for
+                const auto deadline = Clock::now() + timeout_;
+                while (input_.size() < length && Clock::now() < deadline)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    advance();
+                }
+            }
+            const size_t count = std::min(length, input_.size());
+            std::copy(input_.begin(), input_.begin() + static_cast<long>(count), data);
+            input_.erase(input_.begin(), input_.begin() + static_cast<long>(count));
+            return count;
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            advance();
+            arduino_.receive(data, length);
+            collect();
+            return length;
+        }
+
+        size_t available() override
+        {
+            advance();
+            return input_.size();
+        }
+
+        void flush() override
+        {
+        }
+
+        void flush_input() override
+        {
+            input_.clear();
+        }
+
+    private:
+        void advance()
+        {
+            const auto now = Clock::now();
+            arduino_.advance(std::chrono::duration<double>(now - last_).count());
+            last_ = now;
+            collect();
+        }
+
+        void collect()
+        {
+            auto &output = arduino_.output();
+            input_.insert(input_.end(), output.begin(), output.end());
+            output.clear();
+            // replies are immediate; the firmware time of sonar pings is not simulated
+            arduino_.take_busy_time();
+        }
+
+        VirtualArduino arduino_;
+        std::deque<uint8_t> input_;
+        Clock::time_point last_ = Clock::now();
+        Clock::duration timeout_ = std::chrono::seconds(1);
+        bool open_ = false;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_LOOPBACK_PORT_HPP
@@ -0,0 +1,100 @@
+#ifndef DOGBOT_HARDWARE_PORT_HPP
+#define DOGBOT_HARDWARE_PORT_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <serial/serial.h>
+
+namespace dogbot_hardware
+{
+    // Byte stream to a microcontroller. Serial speaks the protocols over it; a port other than
+    // the real serial device lets the firmware be simulated in-process.
+    class Port
+    {
+    public:
+        virtual ~Port() = default;
+
+        // Opens `device`; reads time out after `timeout_ms`. Throws on failure.
+        virtual void open(const std::string &device, uint32_t baud_rate, uint32_t timeout_ms) = 0;
+
+        virtual void close() = 0;
+
+        virtual bool is_open() const = 0;
+
+        // Blocks until `length` bytes arrived or the read timeout expired; returns the count read.
+        virtual size_t read(uint8_t *data, size_t length) = 0;
+
+        virtual size_t write(const uint8_t *data, size_t length) = 0;
+
+        // Bytes that read() returns without blocking.
+        virtual size_t available() = 0;
+
+        // Waits until everything written has been sent.
+        virtual void flush() = 0;
+
+        // Discards everything received and not yet read.
+        virtual void flush_input() = 0;
+
+        // Host time Serial stamps the traffic with; a replay hands back the recorded readings.
+        virtual std::chrono::steady_clock::time_point now()
+        {
+            return std::chrono::steady_clock::now();
+        }
+    };
+
+    // A serial device such as /dev/arduino.
+    class SerialPort : public Port
+    {
+    public:
+        void open(const std::string &device, uint32_t baud_rate, uint32_t timeout_ms) override
+        {
+            serial_.setPort(device);
+            serial_.setBaudrate(baud_rate);
+            serial_.setTimeout(serial::Timeout::max(), timeout_ms, 0, serial::Timeout::max(), 0);
+            serial_.open();
+        }
+
+        void close() override
+        {
+            serial_.close();
+        }
+
+        bool is_open() const override
+        {
+            return serial_.isOpen();
+        }
+
+        size_t read(uint8_t *data, size_t length) override
+        {
+            return serial_.read(data, length);
+        }
+
+        size_t write(const uint8_t *data, size_t length) override
+        {
+            return serial_.write(data, length);
+        }
+
+        size_t available() override
+        {
+            return serial_.available();
+        }
+
+        void flush() override
+        {
+            serial_.flush();
+        }
+
+        void flush_input() override
+        {
+            serial_.flushInput();
+        }
+
+    private:
+        serial::Serial serial_;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_PORT_HPP
@@ -0,0 +1,454 @@
+#ifndef DOGBOT_HARDWARE_PROTOCOL_HPP
+#define DOGBOT_HARDWARE_PROTOCOL_HPP
+
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace dogbot_hardware
+{
+    enum class Protocol
+    {
+        ASCII,
+        BINARY
+    };
+
+    namespace protocol
+    {
+        // Binary frame exchanged with the firmware, all fields little endian:
+        //
+        //   byte 0        START_BYTE
+        //   byte 1        message type
+        //   byte 2        sequence number
+        //   byte 3        payload length N
+        //   byte 4..4+N   payload
+        //   last 2 bytes  CRC-16/CCITT-FALSE over bytes 1..4+N
+        //
+        // Every request is answered by exactly one frame carrying the request's sequence number.
+        // The host may send several requests before reading any reply; the firmware handles them
+        // in arrival order. Payloads:
+        //
+        //   SYNC      ->  (empty)                    reply ACK
+        //   ENCODERS  ->  (empty)                    reply ENCODERS, 4 x int32 counts (lf, rf, lb, rb)
+        //                                            + uint32 micros() at which they were latched
+        //   SONAR     ->  (empty)                    reply SONAR, uint16 echo time [us]
+        //   MOTOR     ->  4 x int16 [1/1000 count/ms] reply ACK
+        //   SERVO     ->  2 x uint8 [deg]            reply ACK
+        //   CYCLE     ->  MOTOR payload + SERVO payload, or a DELTA payload of any other length
+        //                 reply CYCLE, ENCODERS payload + SONAR payload
+        //   STREAM    ->  uint16 rate [Hz]           reply ACK
+        //   DELTA     ->  uint8 channel mask, then the MOTOR int16 of each set motor bit and the
+        //                 SERVO uint8 of each set servo bit, in bit order   reply ACK
+        //   TRAJECTORY -> uint8 point count N (1..MAX_TRAJECTORY_POINTS), then N x (uint16 [ms]
+        //                 to reach the point + SERVO payload)              reply ACK
+        //
+        // DELTA mask bits 0..3 select the motors (lf, rf, lb, rb), bits 4..5 the servos (forearm,
+        // gripper). Channels outside the mask keep their last commanded value.
+        //
+        // TRAJECTORY moves the servos linearly from where they are to the first point in its time,
+        // then on from point to point; a 0 ms point is reached at once. A new TRAJECTORY replaces
+        // the points not yet reached. Servo values in SERVO, CYCLE or DELTA set the servos at once
+        // and cancel the trajectory.
+        //
+        // A frame that fails its CRC is answered with NACK.
+        //
+        // Telemetry streaming: after STREAM with a non-zero rate the firmware pushes an unsolicited
+        // TELEMETRY frame (ENCODERS payload + SONAR payload, the same layout as the CYCLE reply)
+        // every 1/rate seconds until STREAM 0 is received or the port is reopened. Its sequence
+        // number is a free-running frame counter of the firmware and never matches a request.
+        // TELEMETRY frames may appear between any two reply frames, but never inside one, and
+        // the firmware keeps answering all other requests as usual while streaming. The sonar
+        // field carries the most recent completed ping.
+        constexpr uint8_t START_BYTE = 0xA5;
+        constexpr size_t HEADER_SIZE = 4;
+        constexpr size_t CRC_SIZE = 2;
+        constexpr size_t MAX_PAYLOAD_SIZE = 32;
+        constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_PAYLOAD_SIZE + CRC_SIZE;
+
+        constexpr size_t ENCODERS_PAYLOAD_SIZE = 20;
+        constexpr size_t SONAR_PAYLOAD_SIZE = 2;
+        constexpr size_t FEEDBACK_PAYLOAD_SIZE = ENCODERS_PAYLOAD_SIZE + SONAR_PAYLOAD_SIZE;
+
+        constexpr double MOTOR_SPEED_SCALE = 1000.0;
+
+        constexpr size_t MOTOR_CHANNELS = 4;
+        constexpr size_t SERVO_CHANNELS = 2;
+        constexpr uint8_t MOTOR_MASK = 0x0F;
+        constexpr uint8_t SERVO_MASK = 0x30;
+        constexpr uint8_t ALL_CHANNELS = MOTOR_MASK | SERVO_MASK;
+        constexpr size_t COMMAND_PAYLOAD_SIZE = 2 * MOTOR_CHANNELS + SERVO_CHANNELS;
+
+        constexpr size_t TRAJECTORY_POINT_SIZE = 2 + SERVO_CHANNELS;
+        constexpr size_t MAX_TRAJECTORY_POINTS = (MAX_PAYLOAD_SIZE - 1) / TRAJECTORY_POINT_SIZE;
+
+        enum class MessageType : uint8_t
+        {
+            SYNC = 'S',
+            ENCODERS = 'E',
+            SONAR = 'U',
+            MOTOR = 'M',
+            SERVO = 'P',
+            CYCLE = 'C',
+            STREAM = 'T',
+            DELTA = 'D',
+            TRAJECTORY = 'J',
+            TELEMETRY = 'F',
+            ACK = 'A',
+            NACK = 'N'
+        };
+
+        inline uint16_t crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF)
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                crc ^= static_cast<uint16_t>(data[i]) << 8;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+                }
+            }
+            return crc;
+        }
+
+        inline void put_u16(uint8_t *out, uint16_t value)
+        {
+            out[0] = static_cast<uint8_t>(value & 0xFF);
+            out[1] = static_cast<uint8_t>(value >> 8);
+        }
+
+        inline void put_i16(uint8_t *out, int16_t value)
+        {
+            put_u16(out, static_cast<uint16_t>(value));
+        }
+
+        inline void put_u32(uint8_t *out, uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                out[i] = static_cast<uint8_t>((value >> (8 * i)) & 0xFF);
+            }
+        }
+
+        inline void put_i32(uint8_t *out, int32_t value)
+        {
+            put_u32(out, static_cast<uint32_t>(value));
+        }
+
+        inline uint16_t get_u16(const uint8_t *in)
+        {
+            return static_cast<uint16_t>(in[0] | (in[1] << 8));
+        }
+
+        inline int16_t get_i16(const uint8_t *in)
+        {
+            return static_cast<int16_t>(get_u16(in));
+        }
+
+        inline uint32_t get_u32(const uint8_t *in)
+        {
+            uint32_t raw = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                raw |= static_cast<uint32_t>(in[i]) << (8 * i);
+            }
+            return raw;
+        }
+
+        inline int32_t get_i32(const uint8_t *in)
+        {
+            return static_cast<int32_t>(get_u32(in));
+        }
+
+        // Saturating conversion of a real value to a fixed-point int16 field.
+        inline int16_t to_fixed16(double value, double scale)
+        {
+            const double scaled = std::round(value * scale);
+            if (!(scaled > std::numeric_limits<int16_t>::min()))
+            {
+                return std::numeric_limits<int16_t>::min();
+            }
+            if (scaled > std::numeric_limits<int16_t>::max())
+            {
+                return std::numeric_limits<int16_t>::max();
+            }
+            return static_cast<int16_t>(scaled);
+        }
+
+        // Writes a complete frame into `out` (at least MAX_FRAME_SIZE bytes) and returns its size.
+        inline size_t encode(MessageType type, uint8_t seq, const uint8_t *payload, size_t length, uint8_t *out)
+        {
+            if (length > MAX_PAYLOAD_SIZE)
+            {
+                return 0;
+            }
+            out[0] = START_BYTE;
+            out[1] = static_cast<uint8_t>(type);
+            out[2] = seq;
+            out[3] = static_cast<uint8_t>(length);
+            for (size_t i = 0; i < length; ++i)
+            {
+                out[HEADER_SIZE + i] = payload[i];
+            }
+            put_u16(out + HEADER_SIZE + length, crc16(out + 1, HEADER_SIZE - 1 + length));
+            return HEADER_SIZE + length + CRC_SIZE;
+        }
+
+        // Incremental frame parser. Bytes are fed one at a time; garbage before a start byte
+        // and frames with a bad length or CRC are dropped and the parser resynchronises.
+        class Decoder
+        {
+        public:
+            enum class Result
+            {
+                PENDING,
+                FRAME,
+                ERROR
+            };
+
+            Result feed(uint8_t byte)
+            {
+                if (size_ == 0 && byte != START_BYTE)
+                {
+                    return Result::PENDING;
+                }
+                buffer_[size_++] = byte;
+
+                if (size_ == HEADER_SIZE && buffer_[3] > MAX_PAYLOAD_SIZE)
+                {
+                    size_ = 0;
+                    return Result::ERROR;
+                }
+                if (size_ < HEADER_SIZE || size_ < HEADER_SIZE + buffer_[3] + CRC_SIZE)
+                {
+                    return Result::PENDING;
+                }
+
+                const size_t length = buffer_[3];
+                size_ = 0;
+                if (crc16(buffer_ + 1, HEADER_SIZE - 1 + length) != get_u16(buffer_ + HEADER_SIZE + length))
+                {
+                    return Result::ERROR;
+                }
+                return Result::FRAME;
+            }
+
+            void reset()
+            {
+                size_ = 0;
+            }
+
+            bool idle() const
+            {
+                return size_ == 0;
+            }
+
+            MessageType type() const
+            {
+                return static_cast<MessageType>(buffer_[1]);
+            }
+
+            uint8_t seq() const
+            {
+                return buffer_[2];
+            }
+
+            const uint8_t *payload() const
+            {
+                return buffer_ + HEADER_SIZE;
+            }
+
+            size_t length() const
+            {
+                return buffer_[3];
+            }
+
+        private:
+            uint8_t buffer_[MAX_FRAME_SIZE] = {};
+            size_t size_ = 0;
+        };
+
+        // Writes a DELTA payload carrying the channels in `mask` and returns its size.
+        inline size_t put_delta(uint8_t mask, const int16_t *motor, const uint8_t *servo, uint8_t *out)
+        {
+            size_t size = 0;
+            out[size++] = mask;
+            for (size_t i = 0; i < MOTOR_CHANNELS; ++i)
+            {
+                if (mask & (1u << i))
+                {
+                    put_i16(out + size, motor[i]);
+                    size += 2;
+                }
+            }
+            for (size_t i = 0; i < SERVO_CHANNELS; ++i)
+            {
+                if (mask & (1u << (MOTOR_CHANNELS + i)))
+                {
+                    out[size++] = servo[i];
+                }
+            }
+            return size;
+        }
+
+        // Picks the command channels worth transmitting. A motor counts as changed once it moved
+        // by at least `motor_threshold` LSB from the value last sent, or when it is commanded to
+        // stop; a servo on any change. Every `keyframe_interval`-th command, and the first one
+        // after reset(), sends every channel so the firmware cannot drift from the host for long.
+        class DeltaEncoder
+        {
+        public:
+            void configure(int motor_threshold, int keyframe_interval)
+            {
+                motor_threshold_ = motor_threshold;
+                keyframe_interval_ = keyframe_interval;
+                reset();
+            }
+
+            // Returns the mask of channels to send and records their values as sent.
+            uint8_t update(const int16_t *motor, const uint8_t *servo)
+            {
+                uint8_t mask = 0;
+                if (keyframe_due_ || (keyframe_interval_ > 0 && ++since_keyframe_ >= keyframe_interval_))
+                {
+                    mask = ALL_CHANNELS;
+                    keyframe_due_ = false;
+                    since_keyframe_ = 0;
+                }
+                for (size_t i = 0; i < MOTOR_CHANNELS; ++i)
+                {
+                    const int step = std::abs(static_cast<int>(motor[i]) - static_cast<int>(motor_[i]));
+                    if (step > 0 && (step >= motor_threshold_ || motor[i] == 0))
+                    {
+                        mask |= static_cast<uint8_t>(1u << i);
+                    }
+                    if (mask & (1u << i))
+                    {
+                        motor_[i] = motor[i];
+                    }
+                }
+                for (size_t i = 0; i < SERVO_CHANNELS; ++i)
+                {
+                    if (servo[i] != servo_[i])
+                    {
+                        mask |= static_cast<uint8_t>(1u << (MOTOR_CHANNELS + i));
+                        servo_[i] = servo[i];
+                    }
+                }
+                return mask;
+            }
+
+            // Forces a keyframe, e.g. after a failed exchange left the firmware's state unknown.
+            void reset()
+            {
+                keyframe_due_ = true;
+            }
+
+        private:
+            int motor_threshold_ = 1;
+            int keyframe_interval_ = 0;
+            int since_keyframe_ = 0;
+            bool keyframe_due_ = true;
+            int16_t motor_[MOTOR_CHANNELS] = {};
+            uint8_t servo_[SERVO_CHANNELS] = {};
+        };
+
+        constexpr size_t MAX_ASCII_SIZE = 128;
+
+        // Builds a '<X,field,...>' text command in place, without touching the heap.
+        class AsciiWriter
+        {
+        public:
+            explicit AsciiWriter(char tag)
+            {
+                buffer_[0] = '<';
+                buffer_[1] = tag;
+                size_ = 2;
+            }
+
+            AsciiWriter &field(double value)
+            {
+                buffer_[size_++] = ',';
+                // keep room for the closing '>'
+                const auto result = std::to_chars(buffer_ + size_, buffer_ + MAX_ASCII_SIZE - 1, value,
+                                                  std::chars_format::fixed, 6);
+                return advance(result);
+            }
+
+            AsciiWriter &field(int value)
+            {
+                buffer_[size_++] = ',';
+                const auto result = std::to_chars(buffer_ + size_, buffer_ + MAX_ASCII_SIZE - 1, value);
+                return advance(result);
+            }
+
+            std::string_view finish()
+            {
+                buffer_[size_++] = '>';
+                return {buffer_, size_};
+            }
+
+        private:
+            AsciiWriter &advance(std::to_chars_result result)
+            {
+                if (result.ec == std::errc())
+                {
+                    size_ = static_cast<size_t>(result.ptr - buffer_);
+                }
+                else
+                {
+                    buffer_[size_++] = '0';
+                }
+                return *this;
+            }
+
+            char buffer_[MAX_ASCII_SIZE];
+            size_t size_ = 0;
+        };
+
+        // Parses up to `count` comma separated integers from a reply line into `values`.
+        // Missing or malformed fields read as 0, matching the old atol() behaviour; the return
+        // value is the number of fields that did parse, so callers can reject a bad line.
+        inline size_t parse_fields(std::string_view line, long *values, size_t count)
+        {
+            const char *cursor = line.data();
+            const char *const end = line.data() + line.size();
+            size_t parsed = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+                {
+                    ++cursor;
+                }
+                if (cursor < end && *cursor == '+')
+                {
+                    ++cursor;
+                }
+                values[i] = 0;
+                const auto result = std::from_chars(cursor, end, values[i]);
+                if (result.ec != std::errc())
+                {
+                    values[i] = 0;
+                }
+                else
+                {
+                    ++parsed;
+                }
+                while (cursor < end && *cursor != ',')
+                {
+                    ++cursor;
+                }
+                if (cursor < end)
+                {
+                    ++cursor;
+                }
+            }
+            return parsed;
+        }
+    } // namespace protocol
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_PROTOCOL_HPP
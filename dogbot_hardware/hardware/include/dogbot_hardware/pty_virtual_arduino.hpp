@@ -0,0 +1,246 @@
+#ifndef DOGBOT_HARDWARE_PTY_VIRTUAL_ARDUINO_HPP
+#define DOGBOT_HARDWARE_PTY_VIRTUAL_ARDUINO_HPP
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dogbot_hardware/virtual_arduino.hpp"
+
+namespace dogbot_hardware
+{
+    // Imperfections applied to the virtual link.
+    struct LinkFaults
+    {
+        int baud_rate = 115200;            // emulated wire speed, 0 delivers bytes instantly
+        double latency_ms = 0.0;           // firmware processing time added before every reply
+        double drop_probability = 0.0;     // chance of losing each reply byte
+        double truncate_probability = 0.0; // chance of cutting a reply short
+        double garbage_probability = 0.0;  // chance of prefixing a reply with random bytes
+        unsigned seed = 1;
+    };
+
+    // Serves a VirtualArduino on a pseudo-terminal so that Serial, or the whole hardware
+    // component, can open device() exactly like /dev/arduino.
+    class PtyVirtualArduino
+    {
+    public:
+        explicit PtyVirtualArduino(const LinkFaults &faults = LinkFaults())
+            : faults_(faults), rng_(faults.seed)
+        {
+            master_fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+            if (master_fd_ < 0 || grantpt(master_fd_) != 0 || unlockpt(master_fd_) != 0)
+            {
+                fail("unable to allocate a pseudo-terminal");
+            }
+            char name[128];
+            if (ptsname_r(master_fd_, name, sizeof(name)) != 0)
+            {
+                fail("unable to resolve the pseudo-terminal name");
+            }
+            device_ = name;
+
+            // keep the slave side open so the master never sees a hangup between host sessions
+            slave_fd_ = open(name, O_RDWR | O_NOCTTY);
+            termios tio{};
+            if (slave_fd_ < 0 || tcgetattr(slave_fd_, &tio) != 0)
+            {
+                fail("unable to open the pseudo-terminal slave");
+            }
+            cfmakeraw(&tio);
+            tcsetattr(slave_fd_, TCSANOW, &tio);
+        }
+
+        ~PtyVirtualArduino()
+        {
+            stop();
+            close_fds();
+        }
+
+        PtyVirtualArduino(const PtyVirtualArduino &) = delete;
+        PtyVirtualArduino &operator=(const PtyVirtualArduino &) = delete;
+
+        const std::string &device() const
+        {
+            return device_;
+        }
+
+        void start()
+        {
+            if (running_.exchange(true))
+            {
+                return;
+            }
+            thread_ = std::thread(&PtyVirtualArduino::run, this);
+        }
+
+        void stop()
+        {
+            running_.store(false);
+            if (thread_.joinable())
+            {
+                thread_.join();
+            }
+        }
+
+        // Runs `f` on the device model while the serving thread is held off.
+        template <typename F>
+        void with_arduino(F f)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            f(arduino_);
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        // The destructor does not run for a constructor that throws, so it closes what it opened.
+        [[noreturn]] void fail(const char *what)
+        {
+            close_fds();
+            throw std::runtime_error(what);
+        }
+
+        void close_fds()
+        {
+            if (slave_fd_ >= 0)
+            {
+                close(slave_fd_);
+                slave_fd_ = -1;
+            }
+            if (master_fd_ >= 0)
+            {
+                close(master_fd_);
+                master_fd_ = -1;
+            }
+        }
+
+        struct Chunk
+        {
+            Clock::time_point due;
+            std::vector<uint8_t> bytes;
+        };
+
+        Clock::duration transfer_time(size_t bytes) const
+        {
+            if (faults_.baud_rate <= 0)
+            {
+                return Clock::duration::zero();
+            }
+            // 8N1 framing: ten bit times per byte
+            return std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(10.0 * static_cast<double>(bytes) / faults_.baud_rate));
+        }
+
+        void corrupt(std::vector<uint8_t> &bytes)
+        {
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            if (chance(rng_) < faults_.garbage_probability)
+            {
+                std::uniform_int_distribution<int> count(1, 8);
+                std::uniform_int_distribution<int> value(0, 255);
+                std::vector<uint8_t> garbage(static_cast<size_t>(count(rng_)));
+                for (auto &byte : garbage)
+                {
+                    byte = static_cast<uint8_t>(value(rng_));
+                }
+                bytes.insert(bytes.begin(), garbage.begin(), garbage.end());
+            }
+            if (!bytes.empty() && chance(rng_) < faults_.truncate_probability)
+            {
+                std::uniform_int_distribution<size_t> cut(0, bytes.size() - 1);
+                bytes.resize(cut(rng_));
+            }
+            if (faults_.drop_probability > 0.0)
+            {
+                bytes.erase(std::remove_if(bytes.begin(), bytes.end(),
+                                           [&](uint8_t) { return chance(rng_) < faults_.drop_probability; }),
+                            bytes.end());
+            }
+        }
+
+        void run()
+        {
+            const auto latency = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(faults_.latency_ms));
+            auto last = Clock::now();
+            auto line_free = last;
+            std::deque<Chunk> pending;
+            uint8_t buffer[256];
+
+            while (running_.load())
+            {
+                pollfd fd{master_fd_, POLLIN, 0};
+                const timespec wait{0, 200000};
+                ppoll(&fd, 1, &wait, nullptr);
+
+                const auto now = Clock::now();
+                auto ready = now;
+                std::vector<uint8_t> reply;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (fd.revents & POLLIN)
+                    {
+                        const ssize_t count = ::read(master_fd_, buffer, sizeof(buffer));
+                        if (count > 0)
+                        {
+                            // the request is only complete once its last byte has crossed the wire
+                            ready += transfer_time(static_cast<size_t>(count));
+                            arduino_.receive(buffer, static_cast<size_t>(count));
+                            ready += std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(arduino_.take_busy_time()));
+                        }
+                    }
+                    arduino_.advance(std::chrono::duration<double>(now - last).count());
+                    reply.swap(arduino_.output());
+                }
+                last = now;
+
+                if (!reply.empty())
+                {
+                    corrupt(reply);
+                    line_free = std::max(line_free, ready + latency) + transfer_time(reply.size());
+                    pending.push_back({line_free, std::move(reply)});
+                }
+
+                while (!pending.empty() && pending.front().due <= Clock::now())
+                {
+                    const auto &bytes = pending.front().bytes;
+                    if (!bytes.empty() && ::write(master_fd_, bytes.data(), bytes.size()) < 0)
+                    {
+                        break;
+                    }
+                    pending.pop_front();
+                }
+            }
+        }
+
+        LinkFaults faults_;
+        std::mt19937 rng_;
+        int master_fd_ = -1;
+        int slave_fd_ = -1;
+        std::string device_;
+
+        std::mutex mutex_;
+        VirtualArduino arduino_;
+
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_PTY_VIRTUAL_ARDUINO_HPP
@@ -0,0 +1,196 @@
+#ifndef DOGBOT_HARDWARE_REPLAY_PORT_HPP
+#define DOGBOT_HARDWARE_REPLAY_PORT_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "dogbot_hardware/capture_log.hpp"
+#include "dogbot_hardware/port.hpp"
+
+namespace dogbot_hardware
+{
+    // Port that plays a capture written by CapturePort back to Serial. The host's writes stand
+    // in for the recorded TX records and are otherwise ignored; the RX records between two of
+    // them become readable once the first has been written, and with a positive `speed` not
+    // before their recorded time divided by it. A speed of 0 replays as fast as the host asks.
+    // now() hands back the recorded clock readings in turn, shifted to the time the replay
+    // began, so a synchronous replay stamps and filters the feedback exactly as the original
+    // run did. Each open() resumes after the next OPEN record, so recorded reconnects replay as
+    // such; past the end the board stays silent.
+    class ReplayPort : public Port
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        ReplayPort(const std::string &path, double speed)
+            : reader_(path), speed_(speed), cursor_(reader_.begin())
+        {
+        }
+
+        void open(const std::string & /*device*/, uint32_t /*baud_rate*/, uint32_t timeout_ms) override
+        {
+            while (const auto *record = reader_.record(cursor_))
+            {
+                cursor_ = reader_.next(cursor_);
+                if (record->direction == capture::Direction::OPEN)
+                {
+                    timeout_ = std::chrono::milliseconds(timeout_ms);
+                    origin_stamp_ns_ = stamp_ns_ = record->stamp_ns;
+                    origin_ = Clock::now();
+                    input_.clear();
+                    clock_.clear();
+                    open_ = true;
+                    return;
+                }
+            }
+            throw std::runtime_error("end of the serial capture");
+        }
+
+        void close() override
+        {
+            open_ = false;
+        }
+
+        bool is_open() const override
+        {
+            return open_;
+        }
+
+        size_t read(uint8_t *data, size_t length) override
+        {
+            release();
+            const auto deadline = Clock::now() + timeout_;
+            while (input_.size() < length)
+            {
+                // only an RX record still waiting for its time can arrive before the host writes
+                const auto *record = reader_.record(cursor_);
+                if (record == nullptr || record->direction != capture::Direction::RX)
+                {
+                    break;
+                }
+                const auto due = due_time(*record);
+                if (due > deadline)
+                {
+                    std::this_thread::sleep_until(deadline);
+                    break;
+                }
+                std::this_thread::sleep_until(due);
+                release();
+            }
+            const size_t count = std::min(length, input_.size());
+            std::copy(input_.begin(), input_.begin() + static_cast<long>(count), data);
+            input_.erase(input_.begin(), input_.begin() + static_cast<long>(count));
+            return count;
+        }
+
+        size_t write(const uint8_t * /*data*/, size_t length) override
+        {
+            // what was received before this request in the capture precedes its reply
+            while (const auto *record = reader_.record(cursor_))
+            {
+                if (record->direction == capture::Direction::TX)
+                {
+                    stamp_ns_ = record->stamp_ns;
+                    cursor_ = reader_.next(cursor_);
+                    break;
+                }
+                if (record->direction == capture::Direction::OPEN)
+                {
+                    break;
+                }
+                take();
+            }
+            // readings the host did not ask for again must not shift those after the request
+            clock_.clear();
+            release();
+            return length;
+        }
+
+        size_t available() override
+        {
+            release();
+            return input_.size();
+        }
+
+        void flush() override
+        {
+        }
+
+        void flush_input() override
+        {
+            release();
+            input_.clear();
+        }
+
+        Clock::time_point now() override
+        {
+            release();
+            if (!clock_.empty())
+            {
+                stamp_ns_ = clock_.front();
+                clock_.pop_front();
+            }
+            return origin_ + std::chrono::nanoseconds(stamp_ns_ - origin_stamp_ns_);
+        }
+
+    private:
+        Clock::time_point due_time(const capture::CaptureRecord &record) const
+        {
+            if (speed_ <= 0.0)
+            {
+                return Clock::time_point::min();
+            }
+            const double elapsed = static_cast<double>(record.stamp_ns - origin_stamp_ns_) * 1e-9 / speed_;
+            return origin_ + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(elapsed));
+        }
+
+        // Replays the RX and CLOCK records that are due, up to the next TX or OPEN record.
+        void release()
+        {
+            const auto now = Clock::now();
+            while (const auto *record = reader_.record(cursor_))
+            {
+                if ((record->direction != capture::Direction::RX && record->direction != capture::Direction::CLOCK) ||
+                    due_time(*record) > now)
+                {
+                    return;
+                }
+                take();
+            }
+        }
+
+        void take()
+        {
+            const auto *record = reader_.record(cursor_);
+            if (record->direction == capture::Direction::CLOCK)
+            {
+                clock_.push_back(record->stamp_ns);
+            }
+            else
+            {
+                const uint8_t *bytes = reader_.bytes(cursor_);
+                input_.insert(input_.end(), bytes, bytes + record->length);
+            }
+            cursor_ = reader_.next(cursor_);
+        }
+
+        CaptureReader reader_;
+        double speed_;
+        size_t cursor_;
+        std::deque<uint8_t> input_;
+        std::deque<int64_t> clock_; // recorded readings not yet handed out
+        int64_t origin_stamp_ns_ = 0;
+        int64_t stamp_ns_ = 0; // of the last reading handed out
+        Clock::time_point origin_;
+        Clock::duration timeout_ = std::chrono::seconds(1);
+        bool open_ = false;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_REPLAY_PORT_HPP
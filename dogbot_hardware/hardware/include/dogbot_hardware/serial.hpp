@@ -1,34 +1,85 @@
 #ifndef DOGBOT_HARDWARE_SERIAL_SERIAL_HPP
 #define DOGBOT_HARDWARE_SERIAL_SERIAL_HPP
 
-#include <sstream>
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <serial/serial.h>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
 #include <unistd.h>
 
+#include "dogbot_realtime/realtime_logger.hpp"
+
+#include "dogbot_hardware/clock_sync.hpp"
+#include "dogbot_hardware/link_stats.hpp"
+#include "dogbot_hardware/port.hpp"
+#include "dogbot_hardware/protocol.hpp"
+#include "dogbot_hardware/servo_trajectory.hpp"
+
 namespace dogbot_hardware
 {
+    // Messages Serial logs from the control loop.
+    namespace serial_log
+    {
+        using dogbot_realtime::LogCode;
+        using dogbot_realtime::Severity;
+
+        inline constexpr LogCode OPEN_FAILED = {Severity::ERROR, "Serial Opening Exception: %s"};
+        inline constexpr LogCode CLOSE_FAILED = {Severity::ERROR, "Serial Closing Exception: %s"};
+        inline constexpr LogCode SEND_FAILED = {Severity::ERROR, "Serial Sending Exception: %s; Tried: %s"};
+        inline constexpr LogCode RECEIVE_FAILED = {Severity::ERROR, "Serial Receiving Exception: %s"};
+        inline constexpr LogCode NO_REPLY = {Severity::INFO, "Sent: %s   Received: "};
+    } // namespace serial_log
+
+    // Everything sent to the firmware in one control cycle.
+    struct CycleCommand
+    {
+        double motor_speed[4] = {0.0, 0.0, 0.0, 0.0};
+        int servo_position[2] = {0, 0};
+    };
+
+    // Everything the firmware reports back in one control cycle.
+    struct CycleFeedback
+    {
+        long enc[4] = {0, 0, 0, 0};
+        double range = 0.0;
+        bool has_range = false; // the sonar was sampled; otherwise range is meaningless
+        std::chrono::steady_clock::time_point stamp; // host time at which the encoders were latched
+    };
+
     class Serial
     {
 
     public:
         Serial() = default;
 
-        bool connect(const std::string &serial_device, int32_t baud_rate, int32_t timeout_ms)
+        bool connect(const std::string &serial_device, int32_t baud_rate, int32_t timeout_ms,
+                     Protocol protocol = Protocol::ASCII)
         {
             try
             {
-                serial_.setPort(serial_device);
-                serial_.setBaudrate(baud_rate);
-                serial_.setTimeout(serial::Timeout::max(), timeout_ms, 0, serial::Timeout::max(), 0);
-                serial_.open();
-                serial_.flush();
-                send("<S>", false);
+                protocol_ = protocol;
+                streaming_ = false;
+                abandon_pending();
+                clock_.reset();
+                delta_.reset();
+                trajectory_.forget();
+                port_->open(serial_device, static_cast<uint32_t>(baud_rate), static_cast<uint32_t>(timeout_ms));
+                port_->flush();
+                if (protocol_ == Protocol::BINARY)
+                {
+                    transact(protocol::MessageType::SYNC, nullptr, 0, protocol::MessageType::ACK, 0);
+                }
+                else
+                {
+                    send("<S>", false);
+                }
                 return true;
             }
             catch (std::exception &e)
             {
-                std::cerr << "Serial Opening Exception: " << e.what() << std::endl;
+                report(serial_log::OPEN_FAILED, e.what());
                 return false;
             }
         }
@@ -37,101 +88,828 @@ namespace dogbot_hardware
         {
             try
             {
-                serial_.close();
+                port_->close();
                 return true;
             }
             catch (std::exception &e)
             {
-                std::cerr << "Serial Closing Exception: " << e.what() << std::endl;
+                report(serial_log::CLOSE_FAILED, e.what());
                 return false;
             }
         }
 
         bool connected() const
         {
-            return serial_.isOpen();
+            return port_->is_open();
         }
 
-        std::string send(const std::string &msg_to_send, bool verbose)
+        // Replaces the serial device by another byte stream, e.g. a simulated firmware. Only call
+        // it while disconnected.
+        void set_port(std::unique_ptr<Port> port)
         {
-            serial_.flush();
-            try
+            port_ = std::move(port);
+        }
+
+        // Sends the link's messages to `logger` rather than printing them, which may block. The
+        // logger must outlive the link, or be unset first.
+        void set_logger(dogbot_realtime::RealtimeLogger *logger)
+        {
+            logger_ = logger;
+        }
+
+        // With delta encoding, commands only carry the channels that changed: motors once they
+        // moved by `motor_threshold` [count/ms], servos on any change, and all of them every
+        // `keyframe_interval` commands. Binary links send DELTA frames, ASCII links skip the
+        // <M> or <P> message that would repeat itself; the ASCII <C> exchange always sends all.
+        void set_delta_encoding(bool enabled, double motor_threshold = 0.0, int keyframe_interval = 0)
+        {
+            delta_enabled_ = enabled;
+            delta_.configure(static_cast<int>(std::lround(motor_threshold * protocol::MOTOR_SPEED_SCALE)),
+                             keyframe_interval);
+        }
+
+        // Command channels wired to this board, as a protocol channel mask. Binary links never send
+        // the others, so a board sharing the robot with other controllers only gets its own
+        // channels; the ASCII <C> exchange has to carry all of them and stops the motors it does
+        // not own.
+        void set_channels(uint8_t mask)
+        {
+            channels_ = mask & protocol::ALL_CHANNELS;
+            delta_.reset();
+        }
+
+        // With servo trajectories, a changed servo setpoint is sent as one TRAJECTORY request that
+        // the firmware plays out smoothly at up to `max_velocity` [deg/s] through `points`
+        // waypoints, instead of the servos jumping to it; see ServoTrajectory. The other command
+        // frames then leave the servos alone. Binary links only.
+        void set_servo_trajectory(bool enabled, double max_velocity = 0.0, size_t points = 1)
+        {
+            trajectory_enabled_ = enabled;
+            trajectory_.configure(max_velocity, points);
+            delta_.reset();
+        }
+
+        // Returns a view of the reply line, which stays valid until the next request. An empty
+        // view means the firmware did not answer in time.
+        std::string_view send(std::string_view msg_to_send, bool verbose)
+        {
+            write_line(msg_to_send);
+            const std::string_view line = read_line();
+            if (verbose && line.empty())
             {
-                serial_.write(msg_to_send);
+                report(serial_log::NO_REPLY, msg_to_send);
             }
-            catch (std::exception &e)
+            return line;
+        }
+
+        // Kinds of split exchange, see begin_exchange().
+        enum class Exchange
+        {
+            BATCHED,   // transfer()
+            PIPELINED, // transfer_pipelined()
+            COMMANDS,  // send_commands()
+        };
+
+        // Issues the requests of one exchange and returns without waiting for the replies, which
+        // finish_exchange() then collects. Begin the exchange on every link before finishing any,
+        // and the round-trips of all links overlap. ASCII links can only overlap the reply of the
+        // exchange; they send separate commands synchronously here and have no PIPELINED form.
+        //
+        // Without `with_sonar` the exchange reads the encoders only, so the firmware does not hold
+        // up the cycle with an ultrasonic ping. A BATCHED exchange then replaces its CYCLE request
+        // by the commands followed by an ENCODERS request.
+        void begin_exchange(Exchange exchange, const CycleCommand &command, bool with_sonar = true)
+        {
+            if (exchange_pending_)
+            {
+                throw std::logic_error("previous exchange was not finished");
+            }
+            exchange_ = exchange;
+            exchange_sonar_ = with_sonar && exchange != Exchange::COMMANDS;
+
+            if (protocol_ == Protocol::ASCII)
             {
-                std::cerr << "Serial Sending Exception: " << e.what() << "; Tried: " << msg_to_send << std::endl;
+                if (exchange == Exchange::PIPELINED)
+                {
+                    throw std::logic_error("pipelined exchanges require the binary protocol");
+                }
+                if (exchange == Exchange::COMMANDS || !exchange_sonar_)
+                {
+                    send_ascii_commands(command);
+                    if (exchange == Exchange::COMMANDS)
+                    {
+                        return;
+                    }
+                    write_line("<E>");
+                    exchange_pending_ = true;
+                    return;
+                }
+                protocol::AsciiWriter msg('C');
+                for (size_t i = 0; i < protocol::MOTOR_CHANNELS; ++i)
+                {
+                    msg.field((channels_ & (1u << i)) ? command.motor_speed[i] : 0.0);
+                }
+                msg.field(command.servo_position[0]).field(command.servo_position[1]);
+                write_line(msg.finish());
+                exchange_pending_ = true;
+                return;
             }
 
+            const WireCommand wire = encode_command(command);
             try
             {
-                return serial_.readline(128UL, "\n");
+                exchange_commands_ = 0;
+                size_t requests = 0;
+                if (trajectory_enabled_ && (channels_ & protocol::SERVO_MASK))
+                {
+                    uint8_t payload[protocol::MAX_PAYLOAD_SIZE];
+                    const size_t length = trajectory_.plan(wire.servo, port_->now(), payload);
+                    if (length > 0)
+                    {
+                        exchange_seqs_[requests++] = post(protocol::MessageType::TRAJECTORY, payload, length,
+                                                          protocol::MessageType::ACK, 0);
+                        exchange_commands_ = requests;
+                    }
+                }
+                if (exchange == Exchange::BATCHED && exchange_sonar_)
+                {
+                    uint8_t payload[protocol::COMMAND_PAYLOAD_SIZE + 1];
+                    size_t length = protocol::COMMAND_PAYLOAD_SIZE;
+                    if (wire.mask == protocol::ALL_CHANNELS)
+                    {
+                        put_command(wire, payload);
+                    }
+                    else
+                    {
+                        length = protocol::put_delta(wire.mask, wire.motor, wire.servo, payload);
+                    }
+                    exchange_seqs_[requests++] = post(protocol::MessageType::CYCLE, payload, length,
+                                                      protocol::MessageType::CYCLE, protocol::FEEDBACK_PAYLOAD_SIZE);
+                }
+                else
+                {
+                    exchange_commands_ += post_commands(wire, exchange_seqs_ + requests);
+                    requests = exchange_commands_;
+                    if (exchange != Exchange::COMMANDS)
+                    {
+                        exchange_seqs_[requests++] = post(protocol::MessageType::ENCODERS, nullptr, 0,
+                                                          protocol::MessageType::ENCODERS,
+                                                          protocol::ENCODERS_PAYLOAD_SIZE);
+                    }
+                    if (exchange_sonar_)
+                    {
+                        exchange_seqs_[requests++] = post(protocol::MessageType::SONAR, nullptr, 0,
+                                                          protocol::MessageType::SONAR, protocol::SONAR_PAYLOAD_SIZE);
+                    }
+                }
             }
-            catch (std::exception &e)
+            catch (...)
+            {
+                abandon_pending();
+                throw;
+            }
+            exchange_pending_ = true;
+        }
+
+        // Collects the replies of the exchange begun last. `feedback` is left alone for COMMANDS.
+        void finish_exchange(CycleFeedback &feedback)
+        {
+            if (!exchange_pending_)
             {
-                std::cerr << "Serial Receiving Exception: " << e.what() << "; Tried: " << msg_to_send << std::endl;
+                return;
             }
+            exchange_pending_ = false;
 
-            if (verbose)
+            if (protocol_ == Protocol::ASCII)
             {
-                std::cout << "Sent: " << msg_to_send << "   Received: " << std::endl;
+                long values[5];
+                try
+                {
+                    parse_reply(read_line(), values, exchange_sonar_ ? 5 : 4);
+                }
+                catch (...)
+                {
+                    delta_.reset();
+                    throw;
+                }
+                std::copy(values, values + 4, feedback.enc);
+                if (exchange_sonar_)
+                {
+                    feedback.range = echo_to_range(values[4]);
+                    feedback.has_range = true;
+                }
+                // the ASCII protocol carries no MCU time; assume the firmware sampled mid round-trip
+                sample_stamp_ = line_midpoint();
+                feedback.stamp = sample_stamp_;
+                return;
             }
 
-            return "";
+            try
+            {
+                for (size_t i = 0; i < exchange_commands_; ++i)
+                {
+                    await(exchange_seqs_[i]);
+                }
+                if (exchange_ == Exchange::BATCHED && exchange_sonar_)
+                {
+                    decode_feedback(await(exchange_seqs_[exchange_commands_]), reply_received_, feedback);
+                }
+                else if (exchange_ != Exchange::COMMANDS)
+                {
+                    decode_encoders(await(exchange_seqs_[exchange_commands_]), reply_received_, feedback);
+                    if (exchange_sonar_)
+                    {
+                        feedback.range = echo_to_range(protocol::get_u16(await(exchange_seqs_[exchange_commands_ + 1])));
+                        feedback.has_range = true;
+                    }
+                }
+            }
+            catch (...)
+            {
+                abandon_pending();
+                throw;
+            }
         }
 
-        void read_feedback(long &val_1, long &val_2, long &val_3, long &val_4)
+        // Sends one binary request and waits for a reply of `reply_type` carrying exactly
+        // `reply_length` payload bytes. Returns a pointer to the reply payload, which stays
+        // valid until the next request is posted; throws on timeout, NACK or a malformed reply.
+        const uint8_t *transact(protocol::MessageType type, const uint8_t *payload, size_t length,
+                                protocol::MessageType reply_type, size_t reply_length)
         {
-            std::string response = send("<E>", true);
+            return await(post(type, payload, length, reply_type, reply_length));
+        }
 
-            std::string delimiter = ",";
-            size_t start = 0;
-            size_t end = response.find(delimiter);
+        // Writes a binary request without waiting for its reply and returns its sequence number.
+        // Up to PIPELINE_DEPTH requests may be in flight; collect each reply with await().
+        uint8_t post(protocol::MessageType type, const uint8_t *payload, size_t length,
+                     protocol::MessageType reply_type, size_t reply_length)
+        {
+            Pending *slot = nullptr;
+            bool idle = true;
+            for (auto &pending : pending_)
+            {
+                if (pending.active)
+                {
+                    idle = false;
+                }
+                else if (slot == nullptr)
+                {
+                    slot = &pending;
+                }
+            }
+            if (slot == nullptr)
+            {
+                throw std::runtime_error("too many binary requests in flight");
+            }
+            if (idle && !streaming_)
+            {
+                // nothing outstanding, so anything buffered is a stale reply
+                port_->flush_input();
+                decoder_.reset();
+            }
 
-            std::string token_1 = response.substr(start, end - start);
+            const uint8_t seq = next_seq_++;
+            uint8_t frame[protocol::MAX_FRAME_SIZE];
+            const size_t frame_size = protocol::encode(type, seq, payload, length, frame);
+            const auto sent = port_->now();
+            const size_t written = port_->write(frame, frame_size);
+            LinkStats::bump(stats_.tx_bytes, written);
+            if (written != frame_size)
+            {
+                throw std::runtime_error("short write of binary frame");
+            }
+
+            slot->active = true;
+            slot->done = false;
+            slot->error = nullptr;
+            slot->seq = seq;
+            slot->type = type;
+            slot->sent = sent;
+            slot->reply_type = reply_type;
+            slot->reply_length = reply_length;
+            return seq;
+        }
+
+        // Blocks until the reply to request `seq` has arrived. Replies to other in-flight requests
+        // read along the way are kept for their own await(), TELEMETRY frames for poll_telemetry().
+        // On timeout or a corrupted frame all in-flight requests are abandoned; late replies to
+        // them are recognised by sequence number and discarded. While streaming, a corrupted frame
+        // is skipped instead, since it is most likely telemetry.
+        const uint8_t *await(uint8_t seq)
+        {
+            Pending *slot = find_pending(seq);
+            if (slot == nullptr)
+            {
+                throw std::logic_error("no binary request in flight with this sequence number");
+            }
+
+            uint8_t byte;
+            while (!slot->done)
+            {
+                if (port_->read(&byte, 1) != 1)
+                {
+                    // a frame cut off mid-way is a short read, silence is a timeout
+                    LinkStats::bump(decoder_.idle() ? stats_.timeouts : stats_.short_reads);
+                    abandon_pending();
+                    throw std::runtime_error("timed out waiting for binary reply");
+                }
+                LinkStats::bump(stats_.rx_bytes);
+                const auto result = decoder_.feed(byte);
+                if (result == protocol::Decoder::Result::ERROR)
+                {
+                    LinkStats::bump(stats_.parse_errors);
+                }
+                if (result == protocol::Decoder::Result::ERROR && !streaming_)
+                {
+                    abandon_pending();
+                    throw std::runtime_error("corrupted binary reply");
+                }
+                if (result == protocol::Decoder::Result::FRAME)
+                {
+                    dispatch_frame();
+                }
+            }
 
-            start = end + delimiter.length();
-            end = response.find(delimiter, start);
-            std::string token_2 = response.substr(start, end - start);
+            slot->active = false;
+            if (slot->error != nullptr)
+            {
+                throw std::runtime_error(slot->error);
+            }
+            reply_received_ = slot->received;
+            return slot->payload;
+        }
 
-            start = end + delimiter.length();
-            end = response.find(delimiter, start);
-            std::string token_3 = response.substr(start, end - start);
+        // Issues the motor, servo, encoder and sonar requests back to back and then collects the
+        // four replies, so the firmware's processing of one overlaps the transmission of the next.
+        void transfer_pipelined(const CycleCommand &command, CycleFeedback &feedback)
+        {
+            begin_exchange(Exchange::PIPELINED, command);
+            finish_exchange(feedback);
+        }
 
-            start = end + delimiter.length();
-            end = response.find(delimiter, start);
-            std::string token_4 = response.substr(start, end - start);
+        void read_feedback(long &val_1, long &val_2, long &val_3, long &val_4)
+        {
+            if (protocol_ == Protocol::BINARY)
+            {
+                const uint8_t *reply = transact(protocol::MessageType::ENCODERS, nullptr, 0,
+                                                protocol::MessageType::ENCODERS, protocol::ENCODERS_PAYLOAD_SIZE);
+                CycleFeedback feedback;
+                decode_encoders(reply, reply_received_, feedback);
+                val_1 = feedback.enc[0];
+                val_2 = feedback.enc[1];
+                val_3 = feedback.enc[2];
+                val_4 = feedback.enc[3];
+                return;
+            }
 
-            val_1 = std::atol(token_1.c_str());
-            val_2 = std::atol(token_2.c_str());
-            val_3 = std::atol(token_3.c_str());
-            val_4 = std::atol(token_4.c_str());
+            long values[4];
+            parse_reply(send("<E>", true), values, 4);
+            sample_stamp_ = line_midpoint();
+            val_1 = values[0];
+            val_2 = values[1];
+            val_3 = values[2];
+            val_4 = values[3];
         }
 
         void set_motor_speed(double val_1, double val_2, double val_3, double val_4)
         {
-            std::stringstream ss;
-            ss << std::fixed << std::setprecision(6) << "<M," << val_1 << "," << val_2 << "," << val_3 << ","
-               << val_4 << ">";
-            send(ss.str(), false);
+            if (protocol_ == Protocol::BINARY)
+            {
+                uint8_t payload[8];
+                protocol::put_i16(payload, protocol::to_fixed16(val_1, protocol::MOTOR_SPEED_SCALE));
+                protocol::put_i16(payload + 2, protocol::to_fixed16(val_2, protocol::MOTOR_SPEED_SCALE));
+                protocol::put_i16(payload + 4, protocol::to_fixed16(val_3, protocol::MOTOR_SPEED_SCALE));
+                protocol::put_i16(payload + 6, protocol::to_fixed16(val_4, protocol::MOTOR_SPEED_SCALE));
+                transact(protocol::MessageType::MOTOR, payload, sizeof(payload), protocol::MessageType::ACK, 0);
+                return;
+            }
+
+            protocol::AsciiWriter msg('M');
+            expect_reply(send(msg.field(val_1).field(val_2).field(val_3).field(val_4).finish(), false));
         }
 
         void set_servo_position(int val_1, int val_2)
         {
-            std::stringstream ss;
-            ss << "<P," << val_1 << "," << val_2 << ">";
-            send(ss.str(), false);
+            if (protocol_ == Protocol::BINARY)
+            {
+                const uint8_t payload[2] = {static_cast<uint8_t>(std::clamp(val_1, 0, 180)),
+                                            static_cast<uint8_t>(std::clamp(val_2, 0, 180))};
+                transact(protocol::MessageType::SERVO, payload, sizeof(payload), protocol::MessageType::ACK, 0);
+                return;
+            }
+
+            protocol::AsciiWriter msg('P');
+            expect_reply(send(msg.field(val_1).field(val_2).finish(), false));
         }
 
         void read_sonar(double &range)
         {
-            std::string response = send("<U>", false);
-            range = (double)std::atol(response.c_str()) / 58.2 * 0.01;
+            if (protocol_ == Protocol::BINARY)
+            {
+                const uint8_t *reply = transact(protocol::MessageType::SONAR, nullptr, 0,
+                                                protocol::MessageType::SONAR, protocol::SONAR_PAYLOAD_SIZE);
+                range = echo_to_range(protocol::get_u16(reply));
+                return;
+            }
+
+            long echo;
+            parse_reply(send("<U>", false), &echo, 1);
+            range = echo_to_range(echo);
+        }
+
+        // Sends motor and servo commands and collects encoders and sonar in a single round-trip.
+        void transfer(const CycleCommand &command, CycleFeedback &feedback)
+        {
+            begin_exchange(Exchange::BATCHED, command);
+            finish_exchange(feedback);
+        }
+
+        // Asks the firmware to push TELEMETRY frames at `rate_hz`; 0 stops the stream.
+        void stream(uint16_t rate_hz)
+        {
+            uint8_t payload[2];
+            protocol::put_u16(payload, rate_hz);
+            transact(protocol::MessageType::STREAM, payload, sizeof(payload), protocol::MessageType::ACK, 0);
+            streaming_ = rate_hz > 0;
+            telemetry_fresh_ = false;
+        }
+
+        bool streaming() const
+        {
+            return streaming_;
+        }
+
+        // Sends motor and servo commands without asking for feedback. With delta encoding this
+        // may send nothing at all.
+        void send_commands(const CycleCommand &command)
+        {
+            CycleFeedback unused;
+            begin_exchange(Exchange::COMMANDS, command);
+            finish_exchange(unused);
+        }
+
+        // Consumes whatever bytes are already buffered without blocking. Returns true and fills
+        // `feedback` with the newest complete TELEMETRY frame if one arrived since the last call.
+        bool poll_telemetry(CycleFeedback &feedback)
+        {
+            size_t available = port_->available();
+            uint8_t byte;
+            while (available > 0 && port_->read(&byte, 1) == 1)
+            {
+                --available;
+                LinkStats::bump(stats_.rx_bytes);
+                const auto result = decoder_.feed(byte);
+                if (result == protocol::Decoder::Result::FRAME)
+                {
+                    dispatch_frame();
+                }
+                else if (result == protocol::Decoder::Result::ERROR)
+                {
+                    LinkStats::bump(stats_.parse_errors);
+                }
+            }
+            if (!telemetry_fresh_)
+            {
+                return false;
+            }
+            feedback = telemetry_;
+            telemetry_fresh_ = false;
+            return true;
+        }
+
+        // Host time at which the firmware latched the most recently received encoder counts.
+        std::chrono::steady_clock::time_point sample_stamp() const
+        {
+            return sample_stamp_;
+        }
+
+        // Link health counters; safe to read from any thread while this Serial is in use.
+        LinkStats &stats()
+        {
+            return stats_;
         }
 
+        static constexpr size_t PIPELINE_DEPTH = 4;
+
     private:
-        serial::Serial serial_;
+        // Logs through the logger if there is one, else prints straight away as tools do.
+        template <typename... Args>
+        void report(const dogbot_realtime::LogCode &code, const Args &...args)
+        {
+            if (logger_ != nullptr)
+            {
+                logger_->log(code, args...);
+                return;
+            }
+            dogbot_realtime::LogEvent event;
+            event.set(code, args...);
+            (code.severity >= dogbot_realtime::Severity::WARN ? std::cerr : std::cout) << event.format() << std::endl;
+        }
+
+        struct Pending
+        {
+            bool active = false;
+            bool done = false;
+            const char *error = nullptr;
+            uint8_t seq = 0;
+            protocol::MessageType type = protocol::MessageType::SYNC;
+            std::chrono::steady_clock::time_point sent;
+            std::chrono::steady_clock::time_point received;
+            protocol::MessageType reply_type = protocol::MessageType::ACK;
+            size_t reply_length = 0;
+            uint8_t payload[protocol::MAX_PAYLOAD_SIZE] = {};
+        };
+
+        // A command in wire units, plus the channels that need sending.
+        struct WireCommand
+        {
+            int16_t motor[protocol::MOTOR_CHANNELS];
+            uint8_t servo[protocol::SERVO_CHANNELS];
+            uint8_t mask;
+        };
+
+        WireCommand encode_command(const CycleCommand &command)
+        {
+            WireCommand wire;
+            for (size_t i = 0; i < protocol::MOTOR_CHANNELS; ++i)
+            {
+                wire.motor[i] = protocol::to_fixed16(command.motor_speed[i], protocol::MOTOR_SPEED_SCALE);
+            }
+            for (size_t i = 0; i < protocol::SERVO_CHANNELS; ++i)
+            {
+                wire.servo[i] = static_cast<uint8_t>(std::clamp(command.servo_position[i], 0, 180));
+            }
+            wire.mask = (delta_enabled_ ? delta_.update(wire.motor, wire.servo) : protocol::ALL_CHANNELS) & channels_;
+            if (trajectory_enabled_)
+            {
+                wire.mask &= static_cast<uint8_t>(~protocol::SERVO_MASK);
+            }
+            return wire;
+        }
+
+        void send_ascii_commands(const CycleCommand &command)
+        {
+            const WireCommand wire = encode_command(command);
+            try
+            {
+                if (wire.mask & protocol::MOTOR_MASK)
+                {
+                    set_motor_speed(command.motor_speed[0], command.motor_speed[1],
+                                    command.motor_speed[2], command.motor_speed[3]);
+                }
+                if (wire.mask & protocol::SERVO_MASK)
+                {
+                    set_servo_position(command.servo_position[0], command.servo_position[1]);
+                }
+            }
+            catch (...)
+            {
+                delta_.reset();
+                throw;
+            }
+        }
+
+        // Writes the MOTOR payload followed by the SERVO payload, the full CYCLE request layout.
+        static void put_command(const WireCommand &wire, uint8_t *out)
+        {
+            for (size_t i = 0; i < protocol::MOTOR_CHANNELS; ++i)
+            {
+                protocol::put_i16(out + 2 * i, wire.motor[i]);
+            }
+            std::copy(wire.servo, wire.servo + protocol::SERVO_CHANNELS, out + 2 * protocol::MOTOR_CHANNELS);
+        }
+
+        // Posts the requests carrying `wire`, up to two, and stores their sequence numbers in `seqs`.
+        size_t post_commands(const WireCommand &wire, uint8_t *seqs)
+        {
+            if (delta_enabled_ || trajectory_enabled_ || channels_ != protocol::ALL_CHANNELS)
+            {
+                if (wire.mask == 0)
+                {
+                    return 0;
+                }
+                uint8_t payload[protocol::COMMAND_PAYLOAD_SIZE + 1];
+                const size_t length = protocol::put_delta(wire.mask, wire.motor, wire.servo, payload);
+                seqs[0] = post(protocol::MessageType::DELTA, payload, length, protocol::MessageType::ACK, 0);
+                return 1;
+            }
+            uint8_t payload[protocol::COMMAND_PAYLOAD_SIZE];
+            put_command(wire, payload);
+            seqs[0] = post(protocol::MessageType::MOTOR, payload, 2 * protocol::MOTOR_CHANNELS,
+                           protocol::MessageType::ACK, 0);
+            seqs[1] = post(protocol::MessageType::SERVO, payload + 2 * protocol::MOTOR_CHANNELS,
+                           protocol::SERVO_CHANNELS, protocol::MessageType::ACK, 0);
+            return 2;
+        }
+
+        // Routes a decoded frame to the in-flight request it answers or, for TELEMETRY, to telemetry_.
+        void dispatch_frame()
+        {
+            if (decoder_.type() == protocol::MessageType::TELEMETRY)
+            {
+                if (decoder_.length() == protocol::FEEDBACK_PAYLOAD_SIZE)
+                {
+                    decode_feedback(decoder_.payload(), port_->now(), telemetry_);
+                    telemetry_fresh_ = true;
+                }
+                return;
+            }
+
+            Pending *match = find_pending(decoder_.seq());
+            if (match == nullptr || match->done)
+            {
+                return;
+            }
+            match->done = true;
+            if (decoder_.type() == protocol::MessageType::NACK)
+            {
+                match->error = "binary request rejected by firmware";
+            }
+            else if (decoder_.type() != match->reply_type || decoder_.length() != match->reply_length)
+            {
+                LinkStats::bump(stats_.parse_errors);
+                match->error = "unexpected binary reply";
+            }
+            else
+            {
+                match->received = port_->now();
+                record_rtt(static_cast<uint8_t>(match->type), match->sent);
+                std::copy(decoder_.payload(), decoder_.payload() + decoder_.length(), match->payload);
+            }
+        }
+
+        Pending *find_pending(uint8_t seq)
+        {
+            for (auto &pending : pending_)
+            {
+                if (pending.active && pending.seq == seq)
+                {
+                    return &pending;
+                }
+            }
+            return nullptr;
+        }
+
+        void abandon_pending()
+        {
+            // whatever was in flight may or may not have reached the firmware
+            exchange_pending_ = false;
+            delta_.reset();
+            trajectory_.reset();
+            for (auto &pending : pending_)
+            {
+                pending.active = false;
+            }
+            decoder_.reset();
+        }
+
+        void record_rtt(uint8_t tag, std::chrono::steady_clock::time_point sent)
+        {
+            const auto rtt = port_->now() - sent;
+            stats_.rtt[LinkStats::command_from_tag(tag)].record(
+                static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(rtt).count()));
+        }
+
+        static void expect_reply(std::string_view line)
+        {
+            if (line.empty())
+            {
+                throw std::runtime_error("timed out waiting for ASCII reply");
+            }
+        }
+
+        // Parses an ASCII reply that must carry exactly `count` fields; throws otherwise so that
+        // a lost or mangled line is not mistaken for zero readings.
+        void parse_reply(std::string_view line, long *values, size_t count)
+        {
+            expect_reply(line);
+            if (protocol::parse_fields(line, values, count) != count)
+            {
+                LinkStats::bump(stats_.parse_errors);
+                throw std::runtime_error("malformed ASCII reply");
+            }
+        }
+
+        // Decodes an ENCODERS payload that arrived at host time `received`.
+        void decode_encoders(const uint8_t *payload, std::chrono::steady_clock::time_point received,
+                             CycleFeedback &feedback)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                feedback.enc[i] = protocol::get_i32(payload + 4 * i);
+            }
+            sample_stamp_ = clock_.observe(protocol::get_u32(payload + 16), received);
+            feedback.stamp = sample_stamp_;
+        }
+
+        // Decodes a CYCLE or TELEMETRY payload that arrived at host time `received`.
+        void decode_feedback(const uint8_t *payload, std::chrono::steady_clock::time_point received,
+                             CycleFeedback &feedback)
+        {
+            decode_encoders(payload, received, feedback);
+            feedback.range = echo_to_range(protocol::get_u16(payload + protocol::ENCODERS_PAYLOAD_SIZE));
+            feedback.has_range = true;
+        }
+
+        std::chrono::steady_clock::time_point line_midpoint() const
+        {
+            return line_sent_ + (line_received_ - line_sent_) / 2;
+        }
+
+        static double echo_to_range(long echo_us)
+        {
+            return (double)echo_us / 58.2 * 0.01;
+        }
+
+        // Writes an ASCII request whose reply read_line() collects.
+        void write_line(std::string_view msg_to_send)
+        {
+            port_->flush();
+            line_sent_ = port_->now();
+            line_tag_ = msg_to_send.size() > 1 ? static_cast<uint8_t>(msg_to_send[1]) : 0;
+            try
+            {
+                LinkStats::bump(stats_.tx_bytes,
+                                port_->write(reinterpret_cast<const uint8_t *>(msg_to_send.data()), msg_to_send.size()));
+            }
+            catch (std::exception &e)
+            {
+                report(serial_log::SEND_FAILED, e.what(), msg_to_send);
+            }
+        }
+
+        std::string_view read_line()
+        {
+            try
+            {
+                const std::string_view line = readline();
+                LinkStats::bump(stats_.rx_bytes, line.size());
+                if (line.empty())
+                {
+                    LinkStats::bump(stats_.timeouts);
+                }
+                else if (line.back() != '\n')
+                {
+                    LinkStats::bump(stats_.short_reads);
+                }
+                else if (line_tag_ != 0)
+                {
+                    record_rtt(line_tag_, line_sent_);
+                }
+                line_received_ = port_->now();
+                return line;
+            }
+            catch (std::exception &e)
+            {
+                report(serial_log::RECEIVE_FAILED, e.what());
+            }
+            return {};
+        }
+
+        // Reads one reply line into line_; stops at '\n', a full buffer or the read timeout.
+        std::string_view readline()
+        {
+            size_t size = 0;
+            uint8_t byte;
+            while (size < sizeof(line_) && port_->read(&byte, 1) == 1)
+            {
+                line_[size++] = static_cast<char>(byte);
+                if (byte == '\n')
+                {
+                    break;
+                }
+            }
+            return {line_, size};
+        }
+
+        std::unique_ptr<Port> port_ = std::make_unique<SerialPort>();
+        dogbot_realtime::RealtimeLogger *logger_ = nullptr;
+        Protocol protocol_ = Protocol::ASCII;
+        protocol::Decoder decoder_;
+        Pending pending_[PIPELINE_DEPTH];
+        uint8_t next_seq_ = 0;
+        bool streaming_ = false;
+        bool telemetry_fresh_ = false;
+        CycleFeedback telemetry_;
+        LinkStats stats_;
+        ClockSync clock_;
+        uint8_t channels_ = protocol::ALL_CHANNELS;
+        bool delta_enabled_ = false;
+        protocol::DeltaEncoder delta_;
+        bool trajectory_enabled_ = false;
+        ServoTrajectory trajectory_;
+        Exchange exchange_ = Exchange::BATCHED;
+        bool exchange_pending_ = false;
+        bool exchange_sonar_ = true;
+        size_t exchange_commands_ = 0;
+        uint8_t exchange_seqs_[PIPELINE_DEPTH] = {};
+        std::chrono::steady_clock::time_point sample_stamp_;
+        std::chrono::steady_clock::time_point reply_received_;
+        std::chrono::steady_clock::time_point line_sent_;
+        std::chrono::steady_clock::time_point line_received_;
+        uint8_t line_tag_ = 0;
+        char line_[protocol::MAX_ASCII_SIZE];
     };
 } // namespace dogbot_hardware
 #endif // DOGBOT_HARDWARE_SERIAL_SERIAL_HPP
\ No newline at end of file
@@ -0,0 +1,136 @@
+#ifndef DOGBOT_HARDWARE_SERVO_TRAJECTORY_HPP
+#define DOGBOT_HARDWARE_SERVO_TRAJECTORY_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "dogbot_hardware/protocol.hpp"
+
+namespace dogbot_hardware
+{
+    // Plans the TRAJECTORY requests that move the servos to a new setpoint. A move follows a
+    // minimum-jerk profile whose peak speed is the configured maximum, sampled at evenly spaced
+    // waypoints the firmware interpolates linearly between. The planner keeps its own copy of
+    // the interpolation, so a setpoint changed mid-move starts the next move from where the
+    // servos are rather than from where they were heading.
+    class ServoTrajectory
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Plans moves of at most `max_velocity` [deg/s] through `points` waypoints.
+        void configure(double max_velocity, size_t points)
+        {
+            max_velocity_ = max_velocity;
+            points_ = std::clamp<size_t>(points, 1, protocol::MAX_TRAJECTORY_POINTS);
+            forget();
+        }
+
+        // Makes the next plan() send a move even if the setpoint did not change, e.g. after a
+        // failed exchange that may have lost the previous one.
+        void reset()
+        {
+            replan_ = true;
+        }
+
+        // Like reset(), and also drops the estimate of where the servos are: the next move jumps
+        // straight to its setpoint, as the firmware's own state is unknown after reconnecting.
+        void forget()
+        {
+            replan_ = true;
+            known_ = false;
+        }
+
+        // Writes the TRAJECTORY payload of a move to `target` that starts at `now` and returns its
+        // size, or returns 0 if the servos are already headed there.
+        size_t plan(const uint8_t *target, Clock::time_point now, uint8_t *payload)
+        {
+            bool changed = replan_;
+            for (size_t i = 0; i < protocol::SERVO_CHANNELS; ++i)
+            {
+                changed = changed || target[i] != target_[i];
+            }
+            if (!changed)
+            {
+                return 0;
+            }
+
+            double from[protocol::SERVO_CHANNELS];
+            double distance = 0.0;
+            for (size_t i = 0; i < protocol::SERVO_CHANNELS; ++i)
+            {
+                from[i] = known_ ? position(i, now) : target[i];
+                distance = std::max(distance, std::abs(target[i] - from[i]));
+                target_[i] = target[i];
+            }
+            // a minimum-jerk move peaks at 1.875 times its mean speed
+            const double duration = max_velocity_ > 0.0 ? 1.875 * distance / max_velocity_ : 0.0;
+            const size_t count = distance > 0.0 ? points_ : 1;
+            const auto step_ms = static_cast<uint16_t>(std::clamp(std::lround(duration * 1000.0 / count), 0L, 65535L));
+
+            size_t size = 0;
+            payload[size++] = static_cast<uint8_t>(count);
+            for (size_t k = 0; k < count; ++k)
+            {
+                const double s = minimum_jerk(static_cast<double>(k + 1) / count);
+                protocol::put_u16(payload + size, step_ms);
+                size += 2;
+                for (size_t i = 0; i < protocol::SERVO_CHANNELS; ++i)
+                {
+                    const double waypoint = k + 1 == count ? target[i] : from[i] + s * (target[i] - from[i]);
+                    payload[size++] = static_cast<uint8_t>(std::clamp(std::lround(waypoint), 0L, 180L));
+                    waypoint_[k][i] = payload[size - 1];
+                }
+            }
+            std::copy(from, from + protocol::SERVO_CHANNELS, start_);
+            start_time_ = now;
+            step_ = std::chrono::milliseconds(step_ms);
+            count_ = count;
+            known_ = true;
+            replan_ = false;
+            return size;
+        }
+
+        // Where the firmware has servo `servo` at `now`, by the last move planned [deg].
+        double position(size_t servo, Clock::time_point now) const
+        {
+            if (count_ == 0)
+            {
+                return target_[servo];
+            }
+            const double elapsed = std::chrono::duration<double>(now - start_time_).count();
+            const double step = std::chrono::duration<double>(step_).count();
+            if (step <= 0.0 || elapsed >= step * count_)
+            {
+                return waypoint_[count_ - 1][servo];
+            }
+            const auto k = static_cast<size_t>(std::max(elapsed, 0.0) / step);
+            const double from = k == 0 ? start_[servo] : waypoint_[k - 1][servo];
+            const double fraction = std::max(elapsed, 0.0) / step - static_cast<double>(k);
+            return from + fraction * (waypoint_[k][servo] - from);
+        }
+
+    private:
+        static double minimum_jerk(double t)
+        {
+            return t * t * t * (10.0 - 15.0 * t + 6.0 * t * t);
+        }
+
+        double max_velocity_ = 0.0;
+        size_t points_ = 1;
+        bool replan_ = true;
+        bool known_ = false;
+        uint8_t target_[protocol::SERVO_CHANNELS] = {};
+        // the move in flight
+        double start_[protocol::SERVO_CHANNELS] = {};
+        uint8_t waypoint_[protocol::MAX_TRAJECTORY_POINTS][protocol::SERVO_CHANNELS] = {};
+        Clock::time_point start_time_;
+        Clock::duration step_{};
+        size_t count_ = 0;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_SERVO_TRAJECTORY_HPP
@@ -0,0 +1,60 @@
+#ifndef DOGBOT_HARDWARE_SPSC_QUEUE_HPP
+#define DOGBOT_HARDWARE_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace dogbot_hardware
+{
+    // Bounded wait-free ring for exactly one producer thread and one consumer thread.
+    template <typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        // Producer side. Returns false and drops the item when the ring is full.
+        bool push(const T &item)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+            buffer_[head & (Capacity - 1)] = item;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side. Returns false when the ring is empty.
+        bool pop(T &item)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail == head_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            item = buffer_[tail & (Capacity - 1)];
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side. Drains the ring and keeps only the newest item.
+        bool pop_latest(T &item)
+        {
+            bool popped = false;
+            while (pop(item))
+            {
+                popped = true;
+            }
+            return popped;
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) std::atomic<size_t> tail_{0};
+        T buffer_[Capacity];
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_SPSC_QUEUE_HPP
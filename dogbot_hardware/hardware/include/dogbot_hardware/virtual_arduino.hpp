@@ -0,0 +1,429 @@
+#ifndef DOGBOT_HARDWARE_VIRTUAL_ARDUINO_HPP
+#define DOGBOT_HARDWARE_VIRTUAL_ARDUINO_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "dogbot_hardware/protocol.hpp"
+
+namespace dogbot_hardware
+{
+    // Stand-in for the Arduino firmware. It speaks both the ASCII and the binary protocol and
+    // is backed by a wheel and sonar model: the motors follow the commanded speed with a first
+    // order lag of `motor_time_constant`, the encoders integrate their speed, and the sonar sees a
+    // wall `sonar_range` ahead of where the robot started, which comes closer as the wheels roll
+    // forward by `metres_per_count`. The defaults make the motors ideal and the wall fixed. Host
+    // bytes go in through receive(); replies and pushed telemetry accumulate in output() until the
+    // caller takes them. Like pulseIn() on the real board, every requested ping keeps the firmware
+    // busy for the echo time, which callers collect through take_busy_time().
+    class VirtualArduino
+    {
+    public:
+        double sonar_range = 1.0;         // [m]
+        double motor_time_constant = 0.0; // [s]
+        double metres_per_count = 0.0;    // [m] of forward travel per encoder count
+
+        void receive(const uint8_t *data, size_t length)
+        {
+            for (size_t i = 0; i < length; ++i)
+            {
+                const uint8_t byte = data[i];
+                if (in_ascii_)
+                {
+                    if (byte == '>')
+                    {
+                        in_ascii_ = false;
+                        handle_ascii();
+                    }
+                    else if (ascii_.size() < protocol::MAX_ASCII_SIZE)
+                    {
+                        ascii_.push_back(static_cast<char>(byte));
+                    }
+                    continue;
+                }
+                if (byte == '<' && decoder_.idle())
+                {
+                    in_ascii_ = true;
+                    ascii_.clear();
+                    continue;
+                }
+                const auto result = decoder_.feed(byte);
+                if (result == protocol::Decoder::Result::FRAME)
+                {
+                    handle_binary();
+                }
+                else if (result == protocol::Decoder::Result::ERROR)
+                {
+                    reply(protocol::MessageType::NACK, decoder_.seq(), nullptr, 0);
+                }
+            }
+        }
+
+        // Advances the model by `dt` seconds and emits any telemetry frames that fall due.
+        void advance(double dt)
+        {
+            micros_ += dt * 1e6;
+            const double decay = motor_time_constant > 0.0 ? std::exp(-dt / motor_time_constant) : 0.0;
+            for (int i = 0; i < 4; ++i)
+            {
+                // exact step response of the lag over dt
+                const double lag = actual_speed_[i] - motor_speed_[i];
+                position_[i] += (motor_speed_[i] * dt + lag * motor_time_constant * (1.0 - decay)) * 1000.0;
+                actual_speed_[i] = motor_speed_[i] + lag * decay;
+            }
+            advance_trajectory(dt);
+            if (stream_rate_ == 0)
+            {
+                return;
+            }
+            stream_elapsed_ += dt;
+            const double stream_period = 1.0 / stream_rate_;
+            if (stream_elapsed_ >= stream_period)
+            {
+                stream_elapsed_ = std::fmod(stream_elapsed_, stream_period);
+                // streamed telemetry reports the last ping completed in the background
+                uint8_t payload[protocol::FEEDBACK_PAYLOAD_SIZE];
+                put_feedback(payload, echo_us());
+                reply(protocol::MessageType::TELEMETRY, telemetry_seq_++, payload, sizeof(payload));
+            }
+        }
+
+        std::vector<uint8_t> &output()
+        {
+            return output_;
+        }
+
+        long encoder(int index) const
+        {
+            return static_cast<long>(std::floor(position_[index]));
+        }
+
+        double motor_speed(int index) const
+        {
+            return motor_speed_[index];
+        }
+
+        int servo(int index) const
+        {
+            return static_cast<int>(std::lround(servo_[index]));
+        }
+
+        // Time [s] the requests received so far kept the firmware busy, cleared by the call.
+        double take_busy_time()
+        {
+            const double busy = busy_;
+            busy_ = 0.0;
+            return busy;
+        }
+
+    private:
+        uint16_t echo_us() const
+        {
+            // mecanum wheels all turn forward for forward travel
+            const double travel = (position_[0] + position_[1] + position_[2] + position_[3]) / 4.0 * metres_per_count;
+            const double range = std::max(sonar_range - travel, 0.02);
+            return static_cast<uint16_t>(std::clamp(range * 100.0 * 58.2, 0.0, 65535.0));
+        }
+
+        // Pings the sonar and waits for its echo.
+        uint16_t ping()
+        {
+            const uint16_t echo = echo_us();
+            busy_ += echo * 1e-6;
+            return echo;
+        }
+
+        void put_feedback(uint8_t *payload, uint16_t echo) const
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                protocol::put_i32(payload + 4 * i, static_cast<int32_t>(encoder(i)));
+            }
+            // micros() wraps around like the firmware's
+            protocol::put_u32(payload + 16, static_cast<uint32_t>(std::fmod(micros_, 4294967296.0)));
+            protocol::put_u16(payload + protocol::ENCODERS_PAYLOAD_SIZE, echo);
+        }
+
+        void reply(protocol::MessageType type, uint8_t seq, const uint8_t *payload, size_t length)
+        {
+            uint8_t frame[protocol::MAX_FRAME_SIZE];
+            const size_t size = protocol::encode(type, seq, payload, length, frame);
+            output_.insert(output_.end(), frame, frame + size);
+        }
+
+        void reply_line(const std::string &line)
+        {
+            output_.insert(output_.end(), line.begin(), line.end());
+            output_.push_back('\r');
+            output_.push_back('\n');
+        }
+
+        std::string feedback_line(bool with_sonar)
+        {
+            std::string line = std::to_string(encoder(0)) + "," + std::to_string(encoder(1)) + "," +
+                               std::to_string(encoder(2)) + "," + std::to_string(encoder(3));
+            if (with_sonar)
+            {
+                line += "," + std::to_string(ping());
+            }
+            return line;
+        }
+
+        void handle_ascii()
+        {
+            if (ascii_.empty())
+            {
+                return;
+            }
+            std::vector<double> fields;
+            for (size_t comma = ascii_.find(','); comma != std::string::npos; comma = ascii_.find(',', comma + 1))
+            {
+                fields.push_back(std::strtod(ascii_.c_str() + comma + 1, nullptr));
+            }
+
+            switch (ascii_[0])
+            {
+            case 'E':
+                reply_line(feedback_line(false));
+                break;
+            case 'U':
+                reply_line(std::to_string(ping()));
+                break;
+            case 'M':
+                set_motors(fields, 0);
+                reply_line("OK");
+                break;
+            case 'P':
+                set_servos(fields, 0);
+                reply_line("OK");
+                break;
+            case 'C':
+                set_motors(fields, 0);
+                set_servos(fields, 4);
+                reply_line(feedback_line(true));
+                break;
+            default:
+                reply_line("OK");
+                break;
+            }
+        }
+
+        void handle_binary()
+        {
+            const uint8_t seq = decoder_.seq();
+            const uint8_t *payload = decoder_.payload();
+            const size_t length = decoder_.length();
+            uint8_t out[protocol::FEEDBACK_PAYLOAD_SIZE];
+
+            switch (decoder_.type())
+            {
+            case protocol::MessageType::SYNC:
+                reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                return;
+            case protocol::MessageType::ENCODERS:
+                put_feedback(out, 0);
+                reply(protocol::MessageType::ENCODERS, seq, out, protocol::ENCODERS_PAYLOAD_SIZE);
+                return;
+            case protocol::MessageType::SONAR:
+                protocol::put_u16(out, ping());
+                reply(protocol::MessageType::SONAR, seq, out, protocol::SONAR_PAYLOAD_SIZE);
+                return;
+            case protocol::MessageType::MOTOR:
+                if (length == 8)
+                {
+                    set_motors(payload);
+                    reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                    return;
+                }
+                break;
+            case protocol::MessageType::SERVO:
+                if (length == 2)
+                {
+                    set_servo(0, payload[0]);
+                    set_servo(1, payload[1]);
+                    reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                    return;
+                }
+                break;
+            case protocol::MessageType::TRAJECTORY:
+                if (length > 0 && payload[0] >= 1 && payload[0] <= protocol::MAX_TRAJECTORY_POINTS &&
+                    length == 1 + payload[0] * protocol::TRAJECTORY_POINT_SIZE)
+                {
+                    trajectory_.clear();
+                    for (size_t k = 0; k < payload[0]; ++k)
+                    {
+                        const uint8_t *point = payload + 1 + k * protocol::TRAJECTORY_POINT_SIZE;
+                        TrajectoryPoint target{protocol::get_u16(point) * 1e-3, {}};
+                        std::copy(point + 2, point + 4, target.servo);
+                        trajectory_.push_back(target);
+                    }
+                    std::copy(servo_, servo_ + 2, segment_start_);
+                    segment_elapsed_ = 0.0;
+                    advance_trajectory(0.0);
+                    reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                    return;
+                }
+                break;
+            case protocol::MessageType::CYCLE:
+                if (length == protocol::COMMAND_PAYLOAD_SIZE || apply_delta(payload, length))
+                {
+                    if (length == protocol::COMMAND_PAYLOAD_SIZE)
+                    {
+                        set_motors(payload);
+                        set_servo(0, payload[8]);
+                        set_servo(1, payload[9]);
+                    }
+                    put_feedback(out, ping());
+                    reply(protocol::MessageType::CYCLE, seq, out, sizeof(out));
+                    return;
+                }
+                break;
+            case protocol::MessageType::DELTA:
+                if (apply_delta(payload, length))
+                {
+                    reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                    return;
+                }
+                break;
+            case protocol::MessageType::STREAM:
+                if (length == 2)
+                {
+                    stream_rate_ = protocol::get_u16(payload);
+                    stream_elapsed_ = 0.0;
+                    reply(protocol::MessageType::ACK, seq, nullptr, 0);
+                    return;
+                }
+                break;
+            default:
+                break;
+            }
+            reply(protocol::MessageType::NACK, seq, nullptr, 0);
+        }
+
+        void set_motors(const uint8_t *payload)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                motor_speed_[i] = protocol::get_i16(payload + 2 * i) / protocol::MOTOR_SPEED_SCALE;
+            }
+        }
+
+        // Applies a DELTA payload; returns false and changes nothing if it is malformed.
+        bool apply_delta(const uint8_t *payload, size_t length)
+        {
+            if (length == 0 || (payload[0] & ~protocol::ALL_CHANNELS) != 0)
+            {
+                return false;
+            }
+            const uint8_t mask = payload[0];
+            size_t expected = 1;
+            for (size_t bit = 0; bit < protocol::MOTOR_CHANNELS + protocol::SERVO_CHANNELS; ++bit)
+            {
+                if (mask & (1u << bit))
+                {
+                    expected += bit < protocol::MOTOR_CHANNELS ? 2 : 1;
+                }
+            }
+            if (length != expected)
+            {
+                return false;
+            }
+
+            size_t offset = 1;
+            for (size_t i = 0; i < protocol::MOTOR_CHANNELS; ++i)
+            {
+                if (mask & (1u << i))
+                {
+                    motor_speed_[i] = protocol::get_i16(payload + offset) / protocol::MOTOR_SPEED_SCALE;
+                    offset += 2;
+                }
+            }
+            for (size_t i = 0; i < protocol::SERVO_CHANNELS; ++i)
+            {
+                if (mask & (1u << (protocol::MOTOR_CHANNELS + i)))
+                {
+                    set_servo(i, payload[offset++]);
+                }
+            }
+            return true;
+        }
+
+        void set_motors(const std::vector<double> &fields, size_t offset)
+        {
+            for (size_t i = 0; i < 4 && offset + i < fields.size(); ++i)
+            {
+                motor_speed_[i] = fields[offset + i];
+            }
+        }
+
+        void set_servos(const std::vector<double> &fields, size_t offset)
+        {
+            for (size_t i = 0; i < 2 && offset + i < fields.size(); ++i)
+            {
+                set_servo(i, static_cast<int>(fields[offset + i]));
+            }
+        }
+
+        // A servo set directly stops following the trajectory.
+        void set_servo(size_t index, int position)
+        {
+            servo_[index] = position;
+            trajectory_.clear();
+        }
+
+        // Moves the servos along the trajectory by `dt` seconds, point by point.
+        void advance_trajectory(double dt)
+        {
+            segment_elapsed_ += dt;
+            while (!trajectory_.empty() && segment_elapsed_ >= trajectory_.front().duration)
+            {
+                segment_elapsed_ -= trajectory_.front().duration;
+                std::copy(trajectory_.front().servo, trajectory_.front().servo + 2, servo_);
+                std::copy(servo_, servo_ + 2, segment_start_);
+                trajectory_.erase(trajectory_.begin());
+            }
+            if (trajectory_.empty())
+            {
+                segment_elapsed_ = 0.0;
+                return;
+            }
+            const double fraction = segment_elapsed_ / trajectory_.front().duration;
+            for (int i = 0; i < 2; ++i)
+            {
+                servo_[i] = segment_start_[i] + fraction * (trajectory_.front().servo[i] - segment_start_[i]);
+            }
+        }
+
+        double motor_speed_[4] = {0.0, 0.0, 0.0, 0.0};  // [count/ms] commanded
+        double actual_speed_[4] = {0.0, 0.0, 0.0, 0.0}; // [count/ms]
+        double position_[4] = {0.0, 0.0, 0.0, 0.0};     // [count]
+        double servo_[2] = {90.0, 30.0};                // [deg]
+
+        struct TrajectoryPoint
+        {
+            double duration; // [s] from the previous point
+            double servo[2]; // [deg]
+        };
+        std::vector<TrajectoryPoint> trajectory_; // points not yet reached
+        double segment_start_[2] = {90.0, 30.0};  // [deg] where the current segment began
+        double segment_elapsed_ = 0.0;            // [s]
+
+        double micros_ = 0.0; // [us] since power-up
+        double busy_ = 0.0;   // [s] spent pinging, see take_busy_time()
+
+        uint16_t stream_rate_ = 0;
+        double stream_elapsed_ = 0.0;
+        uint8_t telemetry_seq_ = 0;
+
+        bool in_ascii_ = false;
+        std::string ascii_;
+        protocol::Decoder decoder_;
+        std::vector<uint8_t> output_;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_VIRTUAL_ARDUINO_HPP
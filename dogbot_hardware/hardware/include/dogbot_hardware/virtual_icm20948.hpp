@@ -0,0 +1,213 @@
+#ifndef DOGBOT_HARDWARE_VIRTUAL_ICM20948_HPP
+#define DOGBOT_HARDWARE_VIRTUAL_ICM20948_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+
+#include "dogbot_hardware/i2c_bus.hpp"
+#include "dogbot_hardware/icm20948.hpp"
+
+namespace dogbot_hardware
+{
+    // Stand-in for an I2C bus with an ICM-20948 on it, for running the driver without the chip.
+    // It models the registers the driver uses, the auxiliary master's access to the AK09916 and
+    // the FIFO, which advance() fills with packets of the readings below at the programmed rate.
+    class VirtualIcm20948 : public I2cBus
+    {
+    public:
+        double accel[3] = {0.0, 0.0, icm20948::STANDARD_GRAVITY}; // [m/s^2]
+        double gyro[3] = {0.0, 0.0, 0.0};                         // [rad/s]
+        double mag[3] = {20e-6, 0.0, -40e-6};                     // [T] in the accelerometer frame
+
+        explicit VirtualIcm20948(uint8_t address = 0x68)
+            : address_(address)
+        {
+            reset();
+        }
+
+        void write(uint8_t address, uint8_t reg, const uint8_t *data, size_t length) override
+        {
+            using namespace icm20948;
+            check_address(address);
+            for (size_t i = 0; i < length; ++i, ++reg)
+            {
+                if (reg == REG_BANK_SEL)
+                {
+                    bank_ = (data[i] >> 4) & 0x03;
+                    continue;
+                }
+                regs_[bank_][reg & 0x7F] = data[i];
+                if (bank_ == 0 && reg == PWR_MGMT_1 && (data[i] & 0x80))
+                {
+                    reset();
+                }
+                else if (bank_ == 0 && reg == FIFO_RST && (data[i] & 0x1F))
+                {
+                    fifo_.clear();
+                }
+                else if (bank_ == 3 && reg == I2C_SLV4_CTRL && (data[i] & I2C_SLV_EN))
+                {
+                    run_slv4();
+                }
+            }
+        }
+
+        void read(uint8_t address, uint8_t reg, uint8_t *data, size_t length) override
+        {
+            using namespace icm20948;
+            check_address(address);
+            if (bank_ == 0 && reg == FIFO_R_W)
+            {
+                for (size_t i = 0; i < length; ++i)
+                {
+                    // an empty FIFO reads as 0xFF on the real chip
+                    data[i] = fifo_.empty() ? 0xFF : fifo_.front();
+                    if (!fifo_.empty())
+                    {
+                        fifo_.pop_front();
+                    }
+                }
+                return;
+            }
+            for (size_t i = 0; i < length; ++i, ++reg)
+            {
+                if (bank_ == 0 && reg == FIFO_COUNTH)
+                {
+                    data[i] = static_cast<uint8_t>(fifo_.size() >> 8);
+                }
+                else if (bank_ == 0 && reg == FIFO_COUNTH + 1)
+                {
+                    data[i] = static_cast<uint8_t>(fifo_.size() & 0xFF);
+                }
+                else
+                {
+                    data[i] = reg == REG_BANK_SEL ? static_cast<uint8_t>(bank_ << 4) : regs_[bank_][reg & 0x7F];
+                }
+            }
+        }
+
+        // Advances time by `dt` seconds, queuing the packets sampled meanwhile.
+        void advance(double dt)
+        {
+            using namespace icm20948;
+            const double period = (regs_[2][GYRO_SMPLRT_DIV] + 1) / INTERNAL_RATE;
+            elapsed_ += dt;
+            while (elapsed_ >= period)
+            {
+                elapsed_ -= period;
+                if ((regs_[0][USER_CTRL] & USER_CTRL_FIFO_EN) && regs_[0][FIFO_EN_2] != 0)
+                {
+                    push_packet();
+                }
+            }
+        }
+
+        size_t fifo_size() const
+        {
+            return fifo_.size();
+        }
+
+    private:
+        void check_address(uint8_t address) const
+        {
+            if (address != address_)
+            {
+                throw std::runtime_error("I2C transfer failed: no acknowledge");
+            }
+        }
+
+        void reset()
+        {
+            using namespace icm20948;
+            for (auto &bank : regs_)
+            {
+                std::fill(bank, bank + 128, 0);
+            }
+            regs_[0][WHO_AM_I] = CHIP_ID;
+            regs_[0][PWR_MGMT_1] = 0x41;
+            bank_ = 0;
+            fifo_.clear();
+            elapsed_ = 0.0;
+        }
+
+        // Executes the single-byte transfer programmed into SLV4 against the magnetometer model.
+        void run_slv4()
+        {
+            using namespace icm20948;
+            const uint8_t target = regs_[3][I2C_SLV4_ADDR];
+            const uint8_t reg = regs_[3][I2C_SLV4_REG];
+            if ((target & 0x7F) == MAG_ADDRESS)
+            {
+                if (target & I2C_SLV_READ)
+                {
+                    regs_[3][I2C_SLV4_DI] = reg == MAG_WIA2 ? MAG_ID : mag_regs_[reg & 0x3F];
+                }
+                else
+                {
+                    mag_regs_[reg & 0x3F] = regs_[3][I2C_SLV4_DO];
+                }
+            }
+            regs_[3][I2C_SLV4_CTRL] &= static_cast<uint8_t>(~I2C_SLV_EN);
+            regs_[0][I2C_MST_STATUS] |= I2C_SLV4_DONE;
+        }
+
+        static void put_big_endian(std::deque<uint8_t> &out, double value)
+        {
+            const auto raw = static_cast<uint16_t>(static_cast<int16_t>(std::clamp(std::lround(value), -32768L, 32767L)));
+            out.push_back(static_cast<uint8_t>(raw >> 8));
+            out.push_back(static_cast<uint8_t>(raw & 0xFF));
+        }
+
+        static void put_little_endian(std::deque<uint8_t> &out, double value)
+        {
+            const auto raw = static_cast<uint16_t>(static_cast<int16_t>(std::clamp(std::lround(value), -32768L, 32767L)));
+            out.push_back(static_cast<uint8_t>(raw & 0xFF));
+            out.push_back(static_cast<uint8_t>(raw >> 8));
+        }
+
+        void push_packet()
+        {
+            using namespace icm20948;
+            // snapshot mode: a packet that does not fit is dropped whole or cut short
+            if (fifo_.size() >= FIFO_SIZE)
+            {
+                return;
+            }
+            const int accel_range = 2 << ((regs_[2][ACCEL_CONFIG] >> 1) & 0x03);
+            const int gyro_range = 250 << ((regs_[2][GYRO_CONFIG_1] >> 1) & 0x03);
+            std::deque<uint8_t> packet;
+            for (int i = 0; i < 3; ++i)
+            {
+                put_big_endian(packet, accel[i] / (accel_range * STANDARD_GRAVITY / 32768.0));
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                put_big_endian(packet, gyro[i] / (gyro_range * M_PI / 180.0 / 32768.0));
+            }
+            if (regs_[0][FIFO_EN_1] & 0x01)
+            {
+                const bool measuring = mag_regs_[MAG_CNTL2] != 0;
+                put_little_endian(packet, measuring ? mag[0] / MAG_TESLA_PER_COUNT : 0.0);
+                put_little_endian(packet, measuring ? -mag[1] / MAG_TESLA_PER_COUNT : 0.0);
+                put_little_endian(packet, measuring ? -mag[2] / MAG_TESLA_PER_COUNT : 0.0);
+                packet.push_back(0x00); // TMPS
+                packet.push_back(0x00); // ST2
+            }
+            const size_t room = FIFO_SIZE - fifo_.size();
+            fifo_.insert(fifo_.end(), packet.begin(), packet.begin() + static_cast<long>(std::min(room, packet.size())));
+        }
+
+        uint8_t address_;
+        uint8_t regs_[4][128] = {};
+        uint8_t mag_regs_[64] = {};
+        int bank_ = 0;
+        std::deque<uint8_t> fifo_;
+        double elapsed_ = 0.0;
+    };
+} // namespace dogbot_hardware
+
+#endif // DOGBOT_HARDWARE_VIRTUAL_ICM20948_HPP
@@ -0,0 +1,131 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "dogbot_hardware/icm20948.hpp"
+#include "dogbot_hardware/virtual_icm20948.hpp"
+
+namespace
+{
+    using dogbot_hardware::Icm20948;
+    using dogbot_hardware::ImuSample;
+
+    // Records the length of every FIFO burst the driver reads.
+    class RecordingIcm20948 : public dogbot_hardware::VirtualIcm20948
+    {
+    public:
+        void read(uint8_t address, uint8_t reg, uint8_t *data, size_t length) override
+        {
+            if (reg == dogbot_hardware::icm20948::FIFO_R_W)
+            {
+                bursts.push_back(length);
+            }
+            VirtualIcm20948::read(address, reg, data, length);
+        }
+
+        std::vector<size_t> bursts;
+    };
+
+    std::vector<ImuSample> drain(Icm20948 &imu)
+    {
+        std::vector<ImuSample> samples;
+        imu.read_fifo([&samples](const ImuSample &sample) { samples.push_back(sample); });
+        return samples;
+    }
+
+    TEST(Icm20948Test, decodes_and_scales_fifo_packets)
+    {
+        RecordingIcm20948 chip;
+        // beyond the default ranges, so only the configured ones hold them
+        chip.accel[0] = 50.0;
+        chip.accel[1] = -2.0;
+        chip.accel[2] = 9.8;
+        chip.gyro[0] = 10.0;
+        chip.gyro[1] = -0.2;
+        chip.gyro[2] = 0.3;
+        chip.mag[0] = 20e-6;
+        chip.mag[1] = -10e-6;
+        chip.mag[2] = -40e-6;
+
+        Icm20948::Config config;
+        config.accel_range = 8;
+        config.gyro_range = 1000;
+        Icm20948 imu(chip, config);
+        imu.configure();
+        EXPECT_DOUBLE_EQ(imu.sample_rate(), 225.0);
+
+        chip.advance(0.1);
+        const auto samples = drain(imu);
+        ASSERT_EQ(samples.size(), 22u);
+        for (const auto &sample : samples)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                // within one count of each scale
+                EXPECT_NEAR(sample.accel[i], chip.accel[i], 8 * 9.81 / 32768.0);
+                EXPECT_NEAR(sample.gyro[i], chip.gyro[i], 1000 * M_PI / 180.0 / 32768.0);
+                EXPECT_NEAR(sample.mag[i], chip.mag[i], dogbot_hardware::icm20948::MAG_TESLA_PER_COUNT);
+            }
+            EXPECT_TRUE(sample.mag_valid);
+        }
+        EXPECT_EQ(chip.fifo_size(), 0u);
+        EXPECT_EQ(imu.overflows(), 0u);
+    }
+
+    TEST(Icm20948Test, splits_reads_into_bursts_of_whole_packets)
+    {
+        RecordingIcm20948 chip;
+        Icm20948::Config config;
+        config.max_burst = 70; // three packets
+        Icm20948 imu(chip, config);
+        imu.configure();
+
+        chip.advance(0.1);
+        EXPECT_EQ(drain(imu).size(), 22u);
+        // 22 packets of 20 bytes: seven bursts of three packets, then the last one
+        ASSERT_EQ(chip.bursts.size(), 8u);
+        for (size_t i = 0; i + 1 < chip.bursts.size(); ++i)
+        {
+            EXPECT_EQ(chip.bursts[i], 60u);
+        }
+        EXPECT_EQ(chip.bursts.back(), 20u);
+    }
+
+    TEST(Icm20948Test, full_fifo_is_delivered_then_reset_and_counted)
+    {
+        RecordingIcm20948 chip;
+        Icm20948 imu(chip, Icm20948::Config());
+        imu.configure();
+
+        // far more than the 512 byte FIFO holds; it stops mid-packet once full
+        chip.advance(1.0);
+        EXPECT_EQ(chip.fifo_size(), dogbot_hardware::icm20948::FIFO_SIZE);
+        EXPECT_EQ(drain(imu).size(), dogbot_hardware::icm20948::FIFO_SIZE / dogbot_hardware::icm20948::PACKET_SIZE);
+        EXPECT_EQ(imu.overflows(), 1u);
+        EXPECT_EQ(chip.fifo_size(), 0u);
+
+        // the reset FIFO fills with whole packets again
+        chip.advance(0.1);
+        const size_t queued = chip.fifo_size();
+        EXPECT_EQ(queued % dogbot_hardware::icm20948::PACKET_SIZE, 0u);
+        const auto samples = drain(imu);
+        ASSERT_EQ(samples.size(), queued / dogbot_hardware::icm20948::PACKET_SIZE);
+        ASSERT_FALSE(samples.empty());
+        EXPECT_NEAR(samples.back().accel[2], dogbot_hardware::icm20948::STANDARD_GRAVITY, 0.01);
+        EXPECT_EQ(imu.overflows(), 1u);
+    }
+} // namespace
@@ -0,0 +1,185 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <exception>
+
+#include "dogbot_hardware/pty_virtual_arduino.hpp"
+#include "dogbot_hardware/serial.hpp"
+
+namespace
+{
+    using dogbot_hardware::LinkFaults;
+    using dogbot_hardware::LinkStats;
+    using dogbot_hardware::Protocol;
+    using dogbot_hardware::PtyVirtualArduino;
+    using dogbot_hardware::Serial;
+
+    constexpr int CYCLES = 100;
+
+    // Connects `serial` to `device`, retrying since a faulty link may garble the handshake, and
+    // clears the counters the attempts left behind.
+    bool connect(Serial &serial, const PtyVirtualArduino &device, Protocol protocol, int32_t timeout_ms = 20)
+    {
+        for (int attempt = 0; attempt < 20; ++attempt)
+        {
+            if (serial.connect(device.device(), 115200, timeout_ms, protocol))
+            {
+                serial.stats().reset();
+                return true;
+            }
+            serial.disconnect();
+        }
+        return false;
+    }
+
+    uint64_t failures(LinkStats &stats)
+    {
+        return stats.timeouts.load() + stats.short_reads.load() + stats.parse_errors.load();
+    }
+
+    TEST(PtyVirtualArduinoTest, clean_link_answers_every_request)
+    {
+        LinkFaults faults;
+        faults.baud_rate = 0;
+        PtyVirtualArduino device(faults);
+        device.start();
+        Serial serial;
+        ASSERT_TRUE(connect(serial, device, Protocol::BINARY));
+
+        long enc[4];
+        double range = 0.0;
+        for (int i = 0; i < CYCLES; ++i)
+        {
+            serial.set_motor_speed(1.0, 1.0, 1.0, 1.0);
+            serial.read_feedback(enc[0], enc[1], enc[2], enc[3]);
+            serial.read_sonar(range);
+        }
+        EXPECT_GT(enc[0], 0);
+        EXPECT_NEAR(range, 1.0, 0.01);
+        EXPECT_EQ(failures(serial.stats()), 0u);
+    }
+
+    TEST(PtyVirtualArduinoTest, latency_delays_every_reply)
+    {
+        LinkFaults faults;
+        faults.baud_rate = 0;
+        faults.latency_ms = 20.0;
+        PtyVirtualArduino device(faults);
+        device.start();
+        Serial serial;
+        ASSERT_TRUE(connect(serial, device, Protocol::BINARY, 100));
+
+        long enc[4];
+        for (int i = 0; i < 5; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            serial.read_feedback(enc[0], enc[1], enc[2], enc[3]);
+            EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+        }
+        EXPECT_EQ(serial.stats().rtt[LinkStats::ENCODERS].count(), 5u);
+        EXPECT_GE(serial.stats().rtt[LinkStats::ENCODERS].max(), 0.02);
+    }
+
+    TEST(PtyVirtualArduinoTest, dropped_bytes_fail_exchanges_that_the_link_recovers_from)
+    {
+        LinkFaults faults;
+        faults.baud_rate = 0;
+        faults.drop_probability = 0.05;
+        PtyVirtualArduino device(faults);
+        device.start();
+        Serial serial;
+        ASSERT_TRUE(connect(serial, device, Protocol::BINARY));
+
+        int failed = 0;
+        for (int i = 0; i < CYCLES; ++i)
+        {
+            long enc[4] = {-1, -1, -1, -1};
+            try
+            {
+                serial.read_feedback(enc[0], enc[1], enc[2], enc[3]);
+                // the motors never run, so a reply that got through reads zero
+                EXPECT_EQ(enc[0], 0);
+            }
+            catch (const std::exception &)
+            {
+                ++failed;
+            }
+        }
+        EXPECT_GT(failed, 0);
+        EXPECT_LT(failed, CYCLES);
+        EXPECT_EQ(failures(serial.stats()), static_cast<uint64_t>(failed));
+    }
+
+    TEST(PtyVirtualArduinoTest, truncated_lines_are_short_reads)
+    {
+        LinkFaults faults;
+        faults.baud_rate = 0;
+        faults.truncate_probability = 1.0;
+        PtyVirtualArduino device(faults);
+        device.start();
+        Serial serial;
+        ASSERT_TRUE(connect(serial, device, Protocol::ASCII));
+
+        for (int i = 0; i < CYCLES; ++i)
+        {
+            long enc[4] = {-1, -1, -1, -1};
+            try
+            {
+                serial.read_feedback(enc[0], enc[1], enc[2], enc[3]);
+                // only cut short after the last field, which still reads right
+                EXPECT_EQ(enc[3], 0);
+            }
+            catch (const std::exception &)
+            {
+            }
+        }
+        // every line lost its end, all of it being a timeout
+        LinkStats &stats = serial.stats();
+        EXPECT_GT(stats.short_reads.load(), 0u);
+        EXPECT_EQ(stats.short_reads.load() + stats.timeouts.load(), static_cast<uint64_t>(CYCLES));
+    }
+
+    TEST(PtyVirtualArduinoTest, garbage_before_frames_is_skipped)
+    {
+        LinkFaults faults;
+        faults.baud_rate = 0;
+        faults.garbage_probability = 1.0;
+        PtyVirtualArduino device(faults);
+        device.start();
+        device.with_arduino([](dogbot_hardware::VirtualArduino &arduino) { arduino.sonar_range = 0.5; });
+        Serial serial;
+        ASSERT_TRUE(connect(serial, device, Protocol::BINARY));
+
+        int failed = 0;
+        for (int i = 0; i < CYCLES; ++i)
+        {
+            double range = 0.0;
+            try
+            {
+                serial.read_sonar(range);
+                EXPECT_NEAR(range, 0.5, 0.01);
+            }
+            catch (const std::exception &)
+            {
+                // garbage holding the start byte opens a bogus frame, which the CRC rejects
+                ++failed;
+            }
+        }
+        EXPECT_LT(failed, CYCLES / 10);
+        EXPECT_EQ(failures(serial.stats()), static_cast<uint64_t>(failed));
+    }
+} // namespace
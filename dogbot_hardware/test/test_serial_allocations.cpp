@@ -0,0 +1,98 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+#include "dogbot_hardware/pty_virtual_arduino.hpp"
+#include "dogbot_hardware/serial.hpp"
+
+namespace
+{
+    // Allocations made by the test thread while counting; the thread serving the virtual
+    // Arduino allocates freely and is not counted.
+    thread_local bool counting = false;
+    thread_local size_t allocations = 0;
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (counting)
+    {
+        ++allocations;
+    }
+    if (void *memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    using dogbot_hardware::Protocol;
+
+    class SerialAllocationTest : public ::testing::TestWithParam<Protocol>
+    {
+    };
+
+    TEST_P(SerialAllocationTest, control_calls_do_not_allocate)
+    {
+        dogbot_hardware::LinkFaults faults;
+        faults.baud_rate = 0;
+        dogbot_hardware::PtyVirtualArduino device(faults);
+        device.start();
+
+        dogbot_hardware::Serial serial;
+        ASSERT_TRUE(serial.connect(device.device(), 115200, 200, GetParam()));
+
+        long enc[4] = {0, 0, 0, 0};
+        double range = 0.0;
+        const auto cycle = [&](int i)
+        {
+            serial.set_motor_speed(1.0, 1.0, 1.0, 1.0);
+            serial.set_servo_position(i % 180, 90);
+            serial.read_feedback(enc[0], enc[1], enc[2], enc[3]);
+            serial.read_sonar(range);
+        };
+
+        // the first cycle may still set up lazily allocated state outside Serial
+        cycle(0);
+        counting = true;
+        for (int i = 1; i <= 100; ++i)
+        {
+            cycle(i);
+        }
+        counting = false;
+
+        EXPECT_EQ(allocations, 0u);
+        EXPECT_GT(enc[0], 0);
+        EXPECT_NEAR(range, 1.0, 0.01);
+        device.with_arduino([](dogbot_hardware::VirtualArduino &arduino) { EXPECT_EQ(arduino.servo(0), 100); });
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Protocols, SerialAllocationTest, ::testing::Values(Protocol::ASCII, Protocol::BINARY));
+} // namespace
@@ -0,0 +1,238 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures control-cycle round-trips per second of every Serial transfer mode against a
+// virtual Arduino behind a pseudo-terminal, with the wire speed of the real link emulated.
+// The "x2" cases split the channels over two boards whose exchanges overlap; the "/5" cases
+// ping the sonar only every fifth cycle. Each ping takes the echo time of a wall --sonar-range
+// metres away.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dogbot_hardware/pty_virtual_arduino.hpp"
+#include "dogbot_hardware/serial.hpp"
+
+namespace
+{
+    using dogbot_hardware::CycleCommand;
+    using dogbot_hardware::CycleFeedback;
+    using dogbot_hardware::Protocol;
+    using dogbot_hardware::Serial;
+
+    enum class Mode
+    {
+        SEQUENTIAL,
+        BATCHED,
+        PIPELINED
+    };
+
+    struct Case
+    {
+        const char *name;
+        Protocol protocol;
+        Mode mode;
+        bool delta;
+        size_t links;
+        int sonar_interval; // [cycles]
+    };
+
+    // Runs one cycle over all links the way the hardware component does: the first link drives
+    // the wheels, the last one holds the sonar.
+    void cycle(std::vector<std::unique_ptr<Serial>> &links, Mode mode, const CycleCommand &command,
+               bool with_sonar, CycleFeedback &feedback)
+    {
+        const Serial::Exchange exchange = mode == Mode::BATCHED     ? Serial::Exchange::BATCHED
+                                          : mode == Mode::PIPELINED ? Serial::Exchange::PIPELINED
+                                                                    : Serial::Exchange::COMMANDS;
+        // as in the hardware component, a failing link does not keep the others from finishing
+        // the exchange they began, which would otherwise still be pending in the next cycle
+        std::exception_ptr error;
+        std::vector<bool> begun(links.size(), false);
+        for (size_t l = 0; l < links.size(); ++l)
+        {
+            try
+            {
+                links[l]->begin_exchange(exchange, command, with_sonar && l + 1 == links.size());
+                begun[l] = true;
+            }
+            catch (const std::exception &)
+            {
+                error = error ? error : std::current_exception();
+            }
+        }
+        for (size_t l = 0; l < links.size(); ++l)
+        {
+            try
+            {
+                if (begun[l])
+                {
+                    links[l]->finish_exchange(feedback);
+                }
+            }
+            catch (const std::exception &)
+            {
+                error = error ? error : std::current_exception();
+            }
+        }
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        if (mode == Mode::SEQUENTIAL)
+        {
+            links.front()->read_feedback(feedback.enc[0], feedback.enc[1], feedback.enc[2], feedback.enc[3]);
+            if (with_sonar)
+            {
+                links.back()->read_sonar(feedback.range);
+            }
+        }
+    }
+
+    double percentile(std::vector<double> &samples, double fraction)
+    {
+        if (samples.empty())
+        {
+            return 0.0;
+        }
+        const auto index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + static_cast<long>(index), samples.end());
+        return samples[index];
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int cycles = 500;
+    double sonar_range = 1.0;
+    dogbot_hardware::LinkFaults faults;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--cycles")
+        {
+            cycles = std::atoi(argv[i + 1]);
+        }
+        else if (arg == "--baud")
+        {
+            faults.baud_rate = std::atoi(argv[i + 1]);
+        }
+        else if (arg == "--latency-ms")
+        {
+            faults.latency_ms = std::atof(argv[i + 1]);
+        }
+        else if (arg == "--sonar-range")
+        {
+            sonar_range = std::atof(argv[i + 1]);
+        }
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--cycles N] [--baud N] [--latency-ms MS] [--sonar-range M]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const Case cases[] = {
+        {"ascii/sequential", Protocol::ASCII, Mode::SEQUENTIAL, false, 1, 1},
+        {"ascii/sequential+d", Protocol::ASCII, Mode::SEQUENTIAL, true, 1, 1},
+        {"ascii/sequential/5", Protocol::ASCII, Mode::SEQUENTIAL, false, 1, 5},
+        {"ascii/batched", Protocol::ASCII, Mode::BATCHED, false, 1, 1},
+        {"ascii/batched x2", Protocol::ASCII, Mode::BATCHED, false, 2, 1},
+        {"binary/sequential", Protocol::BINARY, Mode::SEQUENTIAL, false, 1, 1},
+        {"binary/batched", Protocol::BINARY, Mode::BATCHED, false, 1, 1},
+        {"binary/batched+d", Protocol::BINARY, Mode::BATCHED, true, 1, 1},
+        {"binary/batched/5", Protocol::BINARY, Mode::BATCHED, false, 1, 5},
+        {"binary/batched x2", Protocol::BINARY, Mode::BATCHED, false, 2, 1},
+        {"binary/pipelined", Protocol::BINARY, Mode::PIPELINED, false, 1, 1},
+        {"binary/pipelined+d", Protocol::BINARY, Mode::PIPELINED, true, 1, 1},
+        {"binary/pipelined/5", Protocol::BINARY, Mode::PIPELINED, false, 1, 5},
+        {"binary/pipelined x2", Protocol::BINARY, Mode::PIPELINED, false, 2, 1},
+    };
+
+    std::printf("%-19s %10s %10s %10s %10s %10s %8s\n", "mode", "cycles/s", "p50 [ms]", "p99 [ms]", "max [ms]",
+                "tx [B/cyc]", "errors");
+    for (const auto &test : cases)
+    {
+        std::vector<std::unique_ptr<dogbot_hardware::PtyVirtualArduino>> devices;
+        std::vector<std::unique_ptr<Serial>> links;
+        uint64_t tx_before = 0;
+        for (size_t l = 0; l < test.links; ++l)
+        {
+            devices.push_back(std::make_unique<dogbot_hardware::PtyVirtualArduino>(faults));
+            devices.back()->with_arduino([sonar_range](dogbot_hardware::VirtualArduino &arduino)
+                                         { arduino.sonar_range = sonar_range; });
+            devices.back()->start();
+
+            links.push_back(std::make_unique<Serial>());
+            Serial &serial = *links.back();
+            if (!serial.connect(devices.back()->device(), faults.baud_rate > 0 ? faults.baud_rate : 115200, 1000,
+                                test.protocol))
+            {
+                std::fprintf(stderr, "%s: unable to connect to %s\n", test.name, devices.back()->device().c_str());
+                return 1;
+            }
+            if (test.links > 1)
+            {
+                serial.set_channels(l == 0 ? dogbot_hardware::protocol::MOTOR_MASK
+                                           : dogbot_hardware::protocol::SERVO_MASK);
+            }
+            // "+d" cases: one motor changes per cycle, keyframe once a second at 20 Hz
+            serial.set_delta_encoding(test.delta, 0.002, 20);
+            tx_before += serial.stats().tx_bytes.load();
+        }
+
+        CycleCommand command;
+        CycleFeedback feedback;
+        std::vector<double> latencies;
+        latencies.reserve(static_cast<size_t>(cycles));
+        int errors = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < cycles; ++i)
+        {
+            command.motor_speed[i % 4] = 0.001 * (i % 100);
+            const auto before = std::chrono::steady_clock::now();
+            try
+            {
+                cycle(links, test.mode, command, i % test.sonar_interval == 0, feedback);
+            }
+            catch (const std::exception &)
+            {
+                ++errors;
+            }
+            latencies.push_back(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - before).count());
+        }
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        uint64_t tx_after = 0;
+        for (size_t l = 0; l < test.links; ++l)
+        {
+            tx_after += links[l]->stats().tx_bytes.load();
+            links[l]->disconnect();
+            devices[l]->stop();
+        }
+        const double tx_per_cycle = static_cast<double>(tx_after - tx_before) / cycles;
+
+        const double max = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+        std::printf("%-19s %10.1f %10.3f %10.3f %10.3f %10.1f %8d\n", test.name, cycles / elapsed,
+                    percentile(latencies, 0.5), percentile(latencies, 0.99), max, tx_per_cycle, errors);
+    }
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Copyright 2024 Long Liangmao
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Serves a virtual Arduino on a pseudo-terminal, e.g.
+//
+//   ros2 run dogbot_hardware virtual_arduino --link /tmp/arduino --latency-ms 2 --garbage 0.01
+//
+// and point the `device` hardware parameter at /tmp/arduino.
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+#include "dogbot_hardware/pty_virtual_arduino.hpp"
+
+namespace
+{
+    volatile std::sig_atomic_t g_stop = 0;
+
+    void on_signal(int)
+    {
+        g_stop = 1;
+    }
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr,
+                     "usage: %s [--link PATH] [--baud N] [--latency-ms MS] [--drop P] [--truncate P]\n"
+                     "          [--garbage P] [--range M] [--seed N]\n",
+                     name);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    dogbot_hardware::LinkFaults faults;
+    std::string link;
+    double range = 1.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char *value = argv[++i];
+        if (arg == "--link")
+        {
+            link = value;
+        }
+        else if (arg == "--baud")
+        {
+            faults.baud_rate = std::atoi(value);
+        }
+        else if (arg == "--latency-ms")
+        {
+            faults.latency_ms = std::atof(value);
+        }
+        else if (arg == "--drop")
+        {
+            faults.drop_probability = std::atof(value);
+        }
+        else if (arg == "--truncate")
+        {
+            faults.truncate_probability = std::atof(value);
+        }
+        else if (arg == "--garbage")
+        {
+            faults.garbage_probability = std::atof(value);
+        }
+        else if (arg == "--range")
+        {
+            range = std::atof(value);
+        }
+        else if (arg == "--seed")
+        {
+            faults.seed = static_cast<unsigned>(std::atoi(value));
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    dogbot_hardware::PtyVirtualArduino device(faults);
+    device.with_arduino([range](dogbot_hardware::VirtualArduino &arduino) { arduino.sonar_range = range; });
+
+    if (!link.empty())
+    {
+        unlink(link.c_str());
+        if (symlink(device.device().c_str(), link.c_str()) != 0)
+        {
+            std::fprintf(stderr, "Unable to link %s: %s\n", link.c_str(), std::strerror(errno));
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+
+    device.start();
+    std::printf("Virtual Arduino on %s\n", link.empty() ? device.device().c_str() : link.c_str());
+    std::fflush(stdout);
+
+    while (!g_stop)
+    {
+        pause();
+    }
+
+    device.stop();
+    if (!link.empty())
+    {
+        unlink(link.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+#ifndef DOGBOT_REALTIME_LOG_RING_HPP
+#define DOGBOT_REALTIME_LOG_RING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace dogbot_realtime
+{
+    enum class Severity : uint8_t
+    {
+        DEBUG,
+        INFO,
+        WARN,
+        ERROR
+    };
+
+    // A kind of log message: its severity and printf-style format. Define each code once with
+    // static storage; events refer to it by address, and rate limiting counts per code.
+    struct LogCode
+    {
+        Severity severity;
+        const char *format;
+    };
+
+    // One log message as recorded on a hot path: its code and up to MAX_ARGS arguments, with
+    // strings copied into a fixed buffer so nothing is allocated and no pointer outlives the
+    // call. Conversions are matched to arguments by position; integers, floating point values
+    // and strings may each be printed with any conversion, so "%d" of a double prints it
+    // truncated and "%s" of a number prints it in its natural form.
+    struct LogEvent
+    {
+        static constexpr size_t MAX_ARGS = 8;
+        static constexpr size_t TEXT_SIZE = 96;
+
+        struct Arg
+        {
+            enum class Type : uint8_t
+            {
+                INTEGER,
+                REAL,
+                TEXT
+            };
+            Type type = Type::INTEGER;
+            union
+            {
+                long long integer;
+                double real;
+                uint16_t text; // offset into LogEvent::text
+            };
+        };
+
+        const LogCode *code = nullptr;
+        uint8_t arg_count = 0;
+        uint16_t text_size = 0;
+        Arg args[MAX_ARGS];
+        char text[TEXT_SIZE];
+
+        template <typename... Args>
+        void set(const LogCode &log_code, const Args &...values)
+        {
+            static_assert(sizeof...(Args) <= MAX_ARGS, "too many log arguments");
+            code = &log_code;
+            arg_count = 0;
+            text_size = 0;
+            (add(values), ...);
+        }
+
+        // Renders the message; only called off the hot path.
+        std::string format() const
+        {
+            std::string out;
+            size_t next = 0;
+            for (const char *p = code->format; *p != '\0'; ++p)
+            {
+                if (*p != '%')
+                {
+                    out.push_back(*p);
+                    continue;
+                }
+                if (p[1] == '%')
+                {
+                    out.push_back('%');
+                    ++p;
+                    continue;
+                }
+                // flags, width and precision are kept, length modifiers replaced to suit the argument
+                std::string spec = "%";
+                for (++p; *p != '\0' && std::strchr("-+ #0123456789.", *p) != nullptr; ++p)
+                {
+                    spec.push_back(*p);
+                }
+                while (*p != '\0' && std::strchr("hlLqjzt", *p) != nullptr)
+                {
+                    ++p;
+                }
+                if (*p == '\0')
+                {
+                    break;
+                }
+                if (next < arg_count)
+                {
+                    append(out, spec, *p, args[next++]);
+                }
+                else
+                {
+                    out += "<missing>";
+                }
+            }
+            return out;
+        }
+
+    private:
+        template <typename T>
+        void add(const T &value)
+        {
+            Arg &arg = args[arg_count++];
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                arg.type = Arg::Type::REAL;
+                arg.real = static_cast<double>(value);
+            }
+            else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>)
+            {
+                arg.type = Arg::Type::INTEGER;
+                arg.integer = static_cast<long long>(value);
+            }
+            else
+            {
+                add_text(arg, std::string_view(value));
+            }
+        }
+
+        void add_text(Arg &arg, std::string_view value)
+        {
+            arg.type = Arg::Type::TEXT;
+            arg.text = text_size;
+            const size_t length = std::min(value.size(), TEXT_SIZE - 1 - text_size);
+            std::memcpy(text + text_size, value.data(), length);
+            text_size = static_cast<uint16_t>(text_size + length);
+            text[text_size] = '\0';
+            if (text_size < TEXT_SIZE - 1)
+            {
+                ++text_size;
+            }
+        }
+
+        void append(std::string &out, std::string spec, char conversion, const Arg &arg) const
+        {
+            char buffer[128];
+            const bool integer_conversion = std::strchr("dicouxX", conversion) != nullptr;
+            const bool real_conversion = std::strchr("eEfFgGaA", conversion) != nullptr;
+            int length = 0;
+            if (arg.type == Arg::Type::TEXT || (!integer_conversion && !real_conversion))
+            {
+                const std::string value = arg.type == Arg::Type::TEXT      ? std::string(text + arg.text)
+                                          : arg.type == Arg::Type::INTEGER ? std::to_string(arg.integer)
+                                                                           : std::to_string(arg.real);
+                length = std::snprintf(buffer, sizeof(buffer), (spec + 's').c_str(), value.c_str());
+            }
+            else if (integer_conversion)
+            {
+                const long long value =
+                    arg.type == Arg::Type::INTEGER ? arg.integer : static_cast<long long>(arg.real);
+                length = std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(), value);
+            }
+            else
+            {
+                const double value = arg.type == Arg::Type::REAL ? arg.real : static_cast<double>(arg.integer);
+                length = std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+            }
+            if (length > 0)
+            {
+                out.append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+            }
+        }
+    };
+
+    // Bounded lock-free ring of log events for any number of producer threads and one consumer.
+    // Each cell carries a sequence number telling whose turn it is, so a producer claims a cell
+    // with one compare-and-swap and never waits for another; when the ring is full the event is
+    // dropped and counted instead.
+    template <size_t Capacity>
+    class LogRing
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        LogRing()
+        {
+            for (size_t i = 0; i < Capacity; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Producer side; safe from any thread and never blocks or allocates.
+        template <typename... Args>
+        bool push(const LogCode &code, const Args &...args) noexcept
+        {
+            size_t position = head_.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;)
+            {
+                cell = &cells_[position & (Capacity - 1)];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const auto lag = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+                if (lag == 0)
+                {
+                    if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (lag < 0)
+                {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                else
+                {
+                    position = head_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->event.set(code, args...);
+            cell->sequence.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side. Returns false when no complete event is waiting.
+        bool pop(LogEvent &event)
+        {
+            Cell &cell = cells_[tail_ & (Capacity - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != tail_ + 1)
+            {
+                return false;
+            }
+            event = cell.event;
+            cell.sequence.store(tail_ + Capacity, std::memory_order_release);
+            ++tail_;
+            return true;
+        }
+
+        // Events dropped on a full ring since the last call.
+        uint64_t take_dropped()
+        {
+            return dropped_.exchange(0, std::memory_order_relaxed);
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence{0};
+            LogEvent event;
+        };
+
+        Cell cells_[Capacity];
+        alignas(64) std::atomic<size_t> head_{0};
+        alignas(64) size_t tail_ = 0;
+        std::atomic<uint64_t> dropped_{0};
+    };
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_LOG_RING_HPP
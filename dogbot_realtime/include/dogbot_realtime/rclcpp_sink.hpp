@@ -0,0 +1,36 @@
+#ifndef DOGBOT_REALTIME_RCLCPP_SINK_HPP
+#define DOGBOT_REALTIME_RCLCPP_SINK_HPP
+
+#include <string>
+
+#include "dogbot_realtime/realtime_logger.hpp"
+#include "rclcpp/logger.hpp"
+#include "rclcpp/logging.hpp"
+
+namespace dogbot_realtime
+{
+    // A RealtimeLogger sink that hands each message to `logger` at its severity.
+    inline RealtimeLogger::Sink rclcpp_sink(const rclcpp::Logger &logger)
+    {
+        return [logger](Severity severity, const std::string &message)
+        {
+            switch (severity)
+            {
+            case Severity::DEBUG:
+                RCLCPP_DEBUG(logger, "%s", message.c_str());
+                break;
+            case Severity::INFO:
+                RCLCPP_INFO(logger, "%s", message.c_str());
+                break;
+            case Severity::WARN:
+                RCLCPP_WARN(logger, "%s", message.c_str());
+                break;
+            case Severity::ERROR:
+                RCLCPP_ERROR(logger, "%s", message.c_str());
+                break;
+            }
+        };
+    }
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_RCLCPP_SINK_HPP
@@ -0,0 +1,138 @@
+#ifndef DOGBOT_REALTIME_REALTIME_LOGGER_HPP
+#define DOGBOT_REALTIME_REALTIME_LOGGER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "dogbot_realtime/log_ring.hpp"
+
+namespace dogbot_realtime
+{
+    // Logging for code that must not block. log() only copies its code and arguments into a
+    // LogRing; a background thread formats the events and hands them to the sink, e.g. the
+    // RCLCPP macros, at most `max_rate` times per second for each code on average, in bursts
+    // of up to as many (0 for no limit). The messages of a code over its rate are counted
+    // instead, and the count is appended to its next message, so a link that keeps failing
+    // reports it a few times a second rather than once per cycle.
+    class RealtimeLogger
+    {
+    public:
+        using Sink = std::function<void(Severity, const std::string &)>;
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t CAPACITY = 256;
+
+        explicit RealtimeLogger(Sink sink, double max_rate = 5.0,
+                                Clock::duration period = std::chrono::milliseconds(10))
+            : sink_(std::move(sink)), ring_(std::make_unique<LogRing<CAPACITY>>()),
+              max_rate_(max_rate), period_(period)
+        {
+            thread_ = std::thread([this] { run(); });
+        }
+
+        ~RealtimeLogger()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+
+        RealtimeLogger(const RealtimeLogger &) = delete;
+        RealtimeLogger &operator=(const RealtimeLogger &) = delete;
+
+        // Queues a message; never blocks, allocates or throws. Strings are copied and may be
+        // truncated, and the message is dropped if the ring is full.
+        template <typename... Args>
+        void log(const LogCode &code, const Args &...args) noexcept
+        {
+            ring_->push(code, args...);
+        }
+
+    private:
+        struct Limit
+        {
+            double tokens = -1.0; // messages that may be emitted right away, unset until the first
+            Clock::time_point refilled;
+            uint64_t suppressed = 0;
+        };
+
+        static constexpr LogCode DROPPED = {Severity::WARN, "Log ring full, %llu messages dropped"};
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_)
+            {
+                wake_.wait_for(lock, period_, [this] { return stop_; });
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        }
+
+        void drain()
+        {
+            LogEvent event;
+            while (ring_->pop(event))
+            {
+                emit(event);
+            }
+            const uint64_t dropped = ring_->take_dropped();
+            if (dropped > 0)
+            {
+                event.set(DROPPED, dropped);
+                emit(event);
+            }
+        }
+
+        void emit(const LogEvent &event)
+        {
+            const auto now = Clock::now();
+            Limit &limit = limits_[event.code];
+            if (max_rate_ > 0.0)
+            {
+                const double refill = std::chrono::duration<double>(now - limit.refilled).count() * max_rate_;
+                const double burst = std::max(max_rate_, 1.0);
+                limit.tokens = limit.tokens < 0.0 ? burst : std::min(burst, limit.tokens + refill);
+                limit.refilled = now;
+                if (limit.tokens < 1.0)
+                {
+                    ++limit.suppressed;
+                    return;
+                }
+                limit.tokens -= 1.0;
+            }
+            std::string message = event.format();
+            if (limit.suppressed > 0)
+            {
+                message += " (" + std::to_string(limit.suppressed) + " similar suppressed)";
+                limit.suppressed = 0;
+            }
+            sink_(event.code->severity, message);
+        }
+
+        Sink sink_;
+        std::unique_ptr<LogRing<CAPACITY>> ring_;
+        double max_rate_;
+        Clock::duration period_;
+        std::unordered_map<const LogCode *, Limit> limits_; // drain thread only
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stop_ = false;
+        std::thread thread_;
+    };
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_REALTIME_LOGGER_HPP
@@ -0,0 +1,89 @@
+#ifndef DOGBOT_REALTIME_REALTIME_PUBLISHER_HPP
+#define DOGBOT_REALTIME_REALTIME_PUBLISHER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "dogbot_realtime/triple_buffer.hpp"
+#include "rclcpp/publisher.hpp"
+
+namespace dogbot_realtime
+{
+    // Publishing for code that must not block. The real-time side fills message() and calls
+    // publish(), which hands the message over through a TripleBuffer; a background thread
+    // checks for one every `period` and publishes the latest, so messages published faster
+    // than that replace each other. A period of half the interval at which the real-time side
+    // publishes delays each message by at most that much. Unlike
+    // realtime_tools::RealtimePublisher, neither side takes a lock the other holds.
+    template <typename MessageT>
+    class RealtimePublisher
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Every slot of the buffer starts as `initial`, so that fields the real-time side does
+        // not touch, such as frame ids, are set once here.
+        RealtimePublisher(typename rclcpp::Publisher<MessageT>::SharedPtr publisher, const MessageT &initial,
+                          Clock::duration period)
+            : publisher_(std::move(publisher)), period_(period)
+        {
+            buffer_.reset(initial);
+            thread_ = std::thread([this] { run(); });
+        }
+
+        ~RealtimePublisher()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_one();
+            thread_.join();
+        }
+
+        RealtimePublisher(const RealtimePublisher &) = delete;
+        RealtimePublisher &operator=(const RealtimePublisher &) = delete;
+
+        // Real-time side: the message to fill before publish(). It keeps the fields of an
+        // earlier message, but not necessarily of the last one published.
+        MessageT &message()
+        {
+            return buffer_.write_slot();
+        }
+
+        // Real-time side: queues the filled message; never blocks or allocates.
+        void publish()
+        {
+            buffer_.publish();
+        }
+
+    private:
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_)
+            {
+                wake_.wait_for(lock, period_, [this] { return stop_; });
+                lock.unlock();
+                if (buffer_.fresh())
+                {
+                    publisher_->publish(buffer_.read());
+                }
+                lock.lock();
+            }
+        }
+
+        typename rclcpp::Publisher<MessageT>::SharedPtr publisher_;
+        TripleBuffer<MessageT> buffer_;
+        Clock::duration period_;
+        std::mutex mutex_; // only between the destructor and the publishing thread
+        std::condition_variable wake_;
+        bool stop_ = false;
+        std::thread thread_;
+    };
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_REALTIME_PUBLISHER_HPP
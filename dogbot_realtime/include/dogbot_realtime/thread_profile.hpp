@@ -0,0 +1,97 @@
+#ifndef DOGBOT_REALTIME_THREAD_PROFILE_HPP
+#define DOGBOT_REALTIME_THREAD_PROFILE_HPP
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace dogbot_realtime
+{
+    // Scheduling of a thread with a real-time loop. These usually need CAP_SYS_NICE and
+    // CAP_IPC_LOCK, or matching rtprio and memlock limits; they throw std::system_error when
+    // refused, and the thread carries on as it was.
+    struct ThreadProfile
+    {
+        std::vector<int> cpus; // allowed CPUs, left as inherited if empty
+        int priority = 0;      // SCHED_FIFO priority, 0 for the default time-sharing policy
+    };
+
+    // Restricts the calling thread to `cpus`.
+    inline void pin_thread(const std::vector<int> &cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int cpu : cpus)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+            {
+                throw std::system_error(EINVAL, std::generic_category(), "CPU " + std::to_string(cpu));
+            }
+            CPU_SET(cpu, &set);
+        }
+        const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (result != 0)
+        {
+            throw std::system_error(result, std::generic_category(), "pthread_setaffinity_np");
+        }
+    }
+
+    // CPUs the main thread of the process may run on, which threads inherit unless pinned.
+    inline std::vector<int> process_cpus()
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(getpid(), sizeof(set), &set) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "sched_getaffinity");
+        }
+        std::vector<int> cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    // Runs the calling thread under SCHED_FIFO at `priority`, or under SCHED_OTHER if it is 0.
+    inline void set_thread_priority(int priority)
+    {
+        sched_param param{};
+        param.sched_priority = priority;
+        const int result = pthread_setschedparam(pthread_self(), priority > 0 ? SCHED_FIFO : SCHED_OTHER, &param);
+        if (result != 0)
+        {
+            throw std::system_error(result, std::generic_category(), "pthread_setschedparam");
+        }
+    }
+
+    inline void apply_thread_profile(const ThreadProfile &profile)
+    {
+        if (!profile.cpus.empty())
+        {
+            pin_thread(profile.cpus);
+        }
+        set_thread_priority(profile.priority);
+    }
+
+    // Locks the pages of the process in memory, now and as it grows, so that a loop never
+    // waits for one to be paged back in.
+    inline void lock_memory()
+    {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "mlockall");
+        }
+    }
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_THREAD_PROFILE_HPP
@@ -0,0 +1,71 @@
+#ifndef DOGBOT_REALTIME_TRIPLE_BUFFER_HPP
+#define DOGBOT_REALTIME_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace dogbot_realtime
+{
+    // Hands the latest value from one writer thread to one reader thread without locks. Of the
+    // three slots, the writer fills one, the reader looks at another, and the third holds the
+    // latest value published; publishing and picking it up each swap a slot with that third one
+    // in a single atomic exchange. Neither side ever waits or copies the other's slot, so the
+    // reader can be a real-time loop while the writer, e.g. a subscription callback, allocates
+    // as it fills its slot.
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        // Writer side: the slot to fill before publish(). It keeps whatever it held before.
+        T &write_slot()
+        {
+            return slots_[back_];
+        }
+
+        // Writer side: makes the filled slot the latest value.
+        void publish()
+        {
+            back_ = middle_.exchange(static_cast<uint8_t>(back_ | FRESH), std::memory_order_acq_rel) & INDEX;
+        }
+
+        // Reader side: picks up the latest value if a newer one was published and returns it. It
+        // stays valid, and may be modified, until the next call.
+        T &read()
+        {
+            if (fresh())
+            {
+                front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+            }
+            return slots_[front_];
+        }
+
+        // Reader side: whether a value was published since the last read().
+        bool fresh() const
+        {
+            return (middle_.load(std::memory_order_relaxed) & FRESH) != 0;
+        }
+
+        // Sets every slot to `value`; only while neither side is using the buffer.
+        void reset(const T &value)
+        {
+            for (auto &slot : slots_)
+            {
+                slot = value;
+            }
+            front_ = 0;
+            middle_.store(1, std::memory_order_relaxed);
+            back_ = 2;
+        }
+
+    private:
+        static constexpr uint8_t INDEX = 0x3;
+        static constexpr uint8_t FRESH = 0x4; // set in middle_ until the reader takes the slot
+
+        T slots_[3];
+        uint8_t front_ = 0; // reader only
+        alignas(64) std::atomic<uint8_t> middle_{1};
+        alignas(64) uint8_t back_ = 2; // writer only
+    };
+} // namespace dogbot_realtime
+
+#endif // DOGBOT_REALTIME_TRIPLE_BUFFER_HPP